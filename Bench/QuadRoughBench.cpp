@@ -0,0 +1,1158 @@
+/*
+  ==============================================================================
+
+    QuadRoughBench.cpp
+
+    Headless benchmark of QuadRoughAudioProcessor, results as JSON.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <new>
+
+//==============================================================================
+//Allocations made by the benchmark thread while counting is on
+
+namespace
+{
+    std::atomic<long long> allocationCount { 0 };
+    thread_local bool countingAllocations = false;
+
+    void* allocate(std::size_t size)
+    {
+        if (countingAllocations)
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (void* pointer = std::malloc(size == 0 ? 1 : size))
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+
+    //Counts allocations inside its scope
+    struct AllocationCounter
+    {
+        AllocationCounter() : start(allocationCount.load()) { countingAllocations = true; }
+        ~AllocationCounter() { countingAllocations = false; }
+
+        long long get() const { return allocationCount.load() - start; }
+
+        long long start;
+    };
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    //==============================================================================
+    struct Settings
+    {
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        juce::Array<int> blockSizes { 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+        double seconds = 1.0;
+
+        //CPU budget of one instance, percent of a core: 40 instances per core
+        double budgetPercent = 2.5;
+
+        juce::String suite = "all";
+        juce::String outputFile;
+
+        //--check: run the checks instead of the suites
+        bool check = false;
+    };
+
+    //Result of one configuration, written as one JSON object
+    struct Result
+    {
+        juce::String suite, name;
+        juce::StringPairArray fields;
+        double nsPerSample = 0.0;
+        double worstBlockMicroseconds = 0.0;
+        long long allocations = 0;
+    };
+
+    juce::String toJson(const Result& result)
+    {
+        juce::String json = "{ \"suite\": \"" + result.suite + "\", \"name\": \"" + result.name + "\"";
+
+        for (auto& key : result.fields.getAllKeys())
+            json << ", \"" << key << "\": " << result.fields[key];
+
+        json << ", \"nsPerSample\": " << juce::String(result.nsPerSample, 3)
+             << ", \"worstBlockUs\": " << juce::String(result.worstBlockMicroseconds, 3)
+             << ", \"allocations\": " << juce::String(result.allocations) << " }";
+
+        return json;
+    }
+
+    //==============================================================================
+    void setParameter(QuadRoughAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(id);
+        jassert(parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    //Noise plus a sine, about -6 dBFS, different on both channels
+    template <typename SampleType>
+    void fillInput(juce::AudioBuffer<SampleType>& buffer, juce::Random& random, double& phase, double phaseIncrement)
+    {
+        for (int i = 0; i < buffer.getNumSamples(); i++) {
+
+            float sine = 0.4f * (float)std::sin(phase);
+            phase += phaseIncrement;
+
+            for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+                buffer.setSample(channel, i, (SampleType)(sine + 0.1f * (random.nextFloat() * 2.0f - 1.0f)));
+        }
+    }
+
+    //Runs the processor for settings.seconds of audio, after a short warm up, in float or double
+    template <typename SampleType = float>
+    void measure(QuadRoughAudioProcessor& processor, double sampleRate, int blockSize, double seconds, Result& result)
+    {
+        processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                   : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<SampleType> buffer(juce::jmax(1, processor.getTotalNumInputChannels()), blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1234);
+        double phase = 0.0;
+        double phaseIncrement = juce::MathConstants<double>::twoPi * 220.0 / sampleRate;
+
+        const int numBlocks = juce::jmax(1, (int)(seconds * sampleRate / blockSize));
+        const int warmUpBlocks = juce::jmax(1, numBlocks / 10);
+
+        for (int block = 0; block < warmUpBlocks; block++) {
+
+            fillInput(buffer, random, phase, phaseIncrement);
+            processor.processBlock(buffer, midi);
+        }
+
+       #if QUADROUGH_PROFILING
+        //Stage timings of the measured blocks only
+        processor.getProfiler().reset();
+       #endif
+
+        double totalNs = 0.0;
+        double worstNs = 0.0;
+        long long allocations = 0;
+
+        for (int block = 0; block < numBlocks; block++) {
+
+            fillInput(buffer, random, phase, phaseIncrement);
+
+            AllocationCounter counter;
+            auto start = Clock::now();
+            processor.processBlock(buffer, midi);
+            auto end = Clock::now();
+            allocations += counter.get();
+
+            double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            totalNs += ns;
+            worstNs = juce::jmax(worstNs, ns);
+        }
+
+        processor.releaseResources();
+
+        result.nsPerSample = totalNs / ((double)numBlocks * blockSize);
+        result.worstBlockMicroseconds = worstNs / 1000.0;
+        result.allocations = allocations;
+        result.fields.set("sampleRate", juce::String(sampleRate, 0));
+        result.fields.set("blockSize", juce::String(blockSize));
+
+       #if QUADROUGH_PROFILING
+        //Microseconds per sub-block of a group for the stages, per host block for "block"
+        result.fields.set("stages", processor.getProfiler().toJson());
+       #endif
+    }
+
+    //==============================================================================
+    //Every algorithm, M/S and ceiling combination, at every samplerate and block size
+    void runChainSuite(const Settings& settings, juce::StringArray& output)
+    {
+        const char* algorithms[] = { "CLASSIC", "PRISTINE", "HARD", "MAD" };
+
+        for (int algorithm = 0; algorithm < 4; algorithm++) {
+
+            for (int midSide = 0; midSide < 2; midSide++) {
+
+                for (int ceiling = 0; ceiling < 2; ceiling++) {
+
+                    for (auto sampleRate : settings.sampleRates) {
+
+                        for (auto blockSize : settings.blockSizes) {
+
+                            QuadRoughAudioProcessor processor;
+                            setParameter(processor, "DRIVE", 12.0f);
+                            setParameter(processor, "TONE", 6.0f);
+                            setParameter(processor, "DISTTYPE", (float)algorithm);
+                            setParameter(processor, "MIDSIDE", (float)midSide);
+                            setParameter(processor, "CLIPPER", (float)ceiling);
+
+                            Result result;
+                            result.suite = "chain";
+                            result.name = juce::String(algorithms[algorithm]) + (midSide ? " M/S" : "") + (ceiling ? " ceiling" : "");
+                            result.fields.set("algorithm", "\"" + juce::String(algorithms[algorithm]) + "\"");
+                            result.fields.set("midSide", midSide ? "true" : "false");
+                            result.fields.set("ceiling", ceiling ? "true" : "false");
+
+                            measure(processor, sampleRate, blockSize, settings.seconds, result);
+                            output.add(toJson(result));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    //Power of the aliased components of a shaped sine, relative to the whole output, in dB.
+    //The sine sits exactly on an FFT bin, so its harmonics and their aliases do too: every
+    //bin that is not DC or a harmonic below Nyquist (with the window leakage) is aliasing
+    double measureAliasing(QuadRoughAudioProcessor& processor, double sampleRate)
+    {
+        constexpr int fftOrder = 14;
+        constexpr int fftSize = 1 << fftOrder;
+        constexpr int sineBin = 853;
+        constexpr int leakage = 4;
+
+        const int blockSize = 512;
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        //Skips the filters and oversampling transients
+        const int settleSamples = 8192;
+        const int totalSamples = settleSamples + fftSize + processor.getLatencySamples();
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        std::vector<float> captured;
+        captured.reserve((size_t)totalSamples + blockSize);
+
+        double phaseIncrement = juce::MathConstants<double>::twoPi * sineBin / fftSize;
+        double phase = 0.0;
+
+        while ((int)captured.size() < totalSamples) {
+
+            for (int i = 0; i < blockSize; i++) {
+
+                float sine = 0.5f * (float)std::sin(phase);
+                phase += phaseIncrement;
+                buffer.setSample(0, i, sine);
+                buffer.setSample(1, i, sine);
+            }
+
+            processor.processBlock(buffer, midi);
+            captured.insert(captured.end(), buffer.getReadPointer(0), buffer.getReadPointer(0) + blockSize);
+        }
+
+        processor.releaseResources();
+
+        //Blackman-Harris window on the last fftSize samples
+        std::vector<float> fftData((size_t)fftSize * 2, 0.0f);
+        const float* samples = captured.data() + captured.size() - fftSize;
+
+        for (int i = 0; i < fftSize; i++) {
+
+            double x = juce::MathConstants<double>::twoPi * i / fftSize;
+            double window = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2.0 * x) - 0.01168 * std::cos(3.0 * x);
+            fftData[(size_t)i] = (float)(samples[i] * window);
+        }
+
+        juce::dsp::FFT fft(fftOrder);
+        fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+        std::vector<bool> harmonic((size_t)fftSize / 2 + 1, false);
+
+        for (int bin = 0; bin <= leakage; bin++)
+            harmonic[(size_t)bin] = true;
+
+        for (int multiple = sineBin; multiple <= fftSize / 2 + leakage; multiple += sineBin) {
+
+            for (int bin = multiple - leakage; bin <= multiple + leakage; bin++) {
+
+                if (bin >= 0 && bin <= fftSize / 2)
+                    harmonic[(size_t)bin] = true;
+            }
+        }
+
+        double total = 0.0, aliased = 0.0;
+
+        for (int bin = 0; bin <= fftSize / 2; bin++) {
+
+            double power = (double)fftData[(size_t)bin] * fftData[(size_t)bin];
+            total += power;
+
+            if (!harmonic[(size_t)bin])
+                aliased += power;
+        }
+
+        return 10.0 * std::log10(juce::jmax(aliased, 1.0e-30) / juce::jmax(total, 1.0e-30));
+    }
+
+    //ADAA against oversampling, aliasing and CPU for every algorithm
+    void runAntiAliasingSuite(const Settings& settings, juce::StringArray& output)
+    {
+        struct Mode
+        {
+            const char* name;
+            int quality, oversampling, filter;
+        };
+
+        const Mode modes[] = { { "1x", 0, 0, 0 }, { "ADAA1", 1, 0, 0 }, { "ADAA2", 2, 0, 0 },
+                               { "2x IIR", 0, 1, 0 }, { "4x IIR", 0, 2, 0 }, { "2x FIR", 0, 1, 1 }, { "4x FIR", 0, 2, 1 },
+                               { "ADAA1 + 2x IIR", 1, 1, 0 } };
+
+        const char* algorithms[] = { "CLASSIC", "PRISTINE", "HARD", "MAD" };
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+
+        for (int algorithm = 0; algorithm < 4; algorithm++) {
+
+            for (auto& mode : modes) {
+
+                auto setup = [&](QuadRoughAudioProcessor& processor)
+                {
+                    setParameter(processor, "DRIVE", 12.0f);
+                    setParameter(processor, "DISTTYPE", (float)algorithm);
+                    setParameter(processor, "QUALITY", (float)mode.quality);
+                    setParameter(processor, "OVERSAMPLING", (float)mode.oversampling);
+                    setParameter(processor, "OSFILTER", (float)mode.filter);
+                };
+
+                QuadRoughAudioProcessor timed, analysed;
+                setup(timed);
+                setup(analysed);
+
+                Result result;
+                result.suite = "antialiasing";
+                result.name = juce::String(algorithms[algorithm]) + " " + mode.name;
+                result.fields.set("algorithm", "\"" + juce::String(algorithms[algorithm]) + "\"");
+                result.fields.set("mode", "\"" + juce::String(mode.name) + "\"");
+
+                measure(timed, sampleRate, blockSize, settings.seconds, result);
+                result.fields.set("aliasingDb", juce::String(measureAliasing(analysed, sampleRate), 2));
+                result.fields.set("latencySamples", juce::String(timed.getLatencySamples()));
+                output.add(toJson(result));
+            }
+        }
+    }
+
+    //==============================================================================
+    //Multiband: 1 to 4 bands, with and without oversampling. Reports the cost added per band
+    //over the single band chain and checks the whole instance against the CPU budget
+    void runMultibandSuite(const Settings& settings, juce::StringArray& output)
+    {
+        const int blockSize = 512;
+
+        for (auto sampleRate : settings.sampleRates) {
+
+            //One sample period, in ns, times the share of the core
+            const double budgetNs = 1.0e9 / sampleRate * settings.budgetPercent / 100.0;
+
+            for (int oversampling = 0; oversampling < 3; oversampling++) {
+
+                double singleBandNs = 0.0;
+
+                for (int bands = 1; bands <= 4; bands++) {
+
+                    QuadRoughAudioProcessor processor;
+                    setParameter(processor, "DRIVE", 12.0f);
+                    setParameter(processor, "OVERSAMPLING", (float)oversampling);
+                    setParameter(processor, "BANDS", (float)(bands - 1));
+
+                    //A different algorithm on every band
+                    for (int band = 1; band <= bands; band++)
+                        setParameter(processor, "BAND" + juce::String(band) + "TYPE", (float)(band - 1));
+
+                    Result result;
+                    result.suite = "multiband";
+                    result.name = juce::String(bands) + (bands > 1 ? " bands " : " band ") + juce::String(1 << oversampling) + "x";
+                    result.fields.set("bands", juce::String(bands));
+                    result.fields.set("oversampling", juce::String(1 << oversampling));
+
+                    measure(processor, sampleRate, blockSize, settings.seconds, result);
+
+                    if (bands == 1)
+                        singleBandNs = result.nsPerSample;
+
+                    result.fields.set("nsPerBand", juce::String(bands > 1 ? (result.nsPerSample - singleBandNs) / (bands - 1) : 0.0, 3));
+                    result.fields.set("budgetNs", juce::String(budgetNs, 3));
+                    result.fields.set("withinBudget", result.nsPerSample <= budgetNs ? "true" : "false");
+                    output.add(toJson(result));
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    //Shaper kernels alone: std:: maths, lookup tables and the vector implementation
+    void runKernelSuite(const Settings& settings, juce::StringArray& output)
+    {
+        const ShaperKernels::Table* tables[] = { &ShaperKernels::getScalar(), &ShaperKernels::getLookup(), &ShaperKernels::getBest() };
+        const char* algorithms[] = { "CLASSIC", "PRISTINE", "HARD", "MAD" };
+        const int blockSize = 512;
+        const int numBlocks = juce::jmax(1, (int)(settings.seconds * 48000.0 / blockSize));
+
+        std::vector<float> source((size_t)blockSize), data((size_t)blockSize);
+        juce::Random random(42);
+
+        for (auto& sample : source)
+            sample = random.nextFloat() * 2.0f - 1.0f;
+
+        for (auto* table : tables) {
+
+            const ShaperKernels::Kernel kernels[] = { table->classic, table->pristine, table->hard, table->mad };
+
+            for (int algorithm = 0; algorithm < 4; algorithm++) {
+
+                double totalNs = 0.0, worstNs = 0.0;
+
+                for (int block = 0; block < numBlocks; block++) {
+
+                    std::copy(source.begin(), source.end(), data.begin());
+
+                    auto start = Clock::now();
+                    kernels[algorithm](data.data(), blockSize, 3.0f, 1.0f);
+                    auto end = Clock::now();
+
+                    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+                    totalNs += ns;
+                    worstNs = juce::jmax(worstNs, ns);
+                }
+
+                Result result;
+                result.suite = "kernels";
+                result.name = juce::String(algorithms[algorithm]) + " " + table->name;
+                result.fields.set("algorithm", "\"" + juce::String(algorithms[algorithm]) + "\"");
+                result.fields.set("implementation", "\"" + juce::String(table->name) + "\"");
+                result.nsPerSample = totalNs / ((double)numBlocks * blockSize);
+                result.worstBlockMicroseconds = worstNs / 1000.0;
+                output.add(toJson(result));
+            }
+        }
+    }
+
+    //==============================================================================
+    //Session recall: setStateInformation with the binary state and with the XML of earlier versions,
+    //and factory presets switched at every block, which must not allocate in processBlock
+    void runStateSuite(const Settings& settings, juce::StringArray& output)
+    {
+        const int numRecalls = juce::jmax(10, (int)(settings.seconds * 2000.0));
+
+        QuadRoughAudioProcessor processor;
+        setParameter(processor, "DRIVE", 12.0f);
+        setParameter(processor, "BANDS", 2.0f);
+
+        juce::MemoryBlock binary, xml;
+        processor.getStateInformation(binary);
+
+        if (auto element = processor.apvts.copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary(*element, xml);
+
+        const std::pair<const char*, const juce::MemoryBlock*> formats[] = { { "binary", &binary }, { "xml", &xml } };
+
+        for (auto& format : formats) {
+
+            auto start = Clock::now();
+
+            for (int recall = 0; recall < numRecalls; recall++)
+                processor.setStateInformation(format.second->getData(), (int)format.second->getSize());
+
+            auto end = Clock::now();
+            double usPerRecall = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000.0 / numRecalls;
+
+            Result result;
+            result.suite = "state";
+            result.name = juce::String("recall ") + format.first;
+            result.fields.set("bytes", juce::String((int)format.second->getSize()));
+            result.fields.set("usPerRecall", juce::String(usPerRecall, 3));
+            result.fields.set("session300Ms", juce::String(usPerRecall * 300.0 / 1000.0, 3));
+            output.add(toJson(result));
+        }
+
+        //One preset per block, applied on the message thread (this one) before the block
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        const int numBlocks = juce::jmax(processor.getNumPrograms(), (int)(settings.seconds * sampleRate / blockSize));
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1234);
+        double phase = 0.0, totalNs = 0.0, worstNs = 0.0;
+        long long allocations = 0;
+
+        for (int block = 0; block < numBlocks; block++) {
+
+            fillInput(buffer, random, phase, juce::MathConstants<double>::twoPi * 220.0 / sampleRate);
+            processor.setCurrentProgram(block % processor.getNumPrograms());
+
+            AllocationCounter counter;
+            auto start = Clock::now();
+            processor.processBlock(buffer, midi);
+            auto end = Clock::now();
+            allocations += counter.get();
+
+            double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            totalNs += ns;
+            worstNs = juce::jmax(worstNs, ns);
+        }
+
+        processor.releaseResources();
+
+        Result result;
+        result.suite = "state";
+        result.name = "preset switch";
+        result.fields.set("presets", juce::String(processor.getNumPrograms()));
+        result.nsPerSample = totalNs / ((double)numBlocks * blockSize);
+        result.worstBlockMicroseconds = worstNs / 1000.0;
+        result.allocations = allocations;
+        output.add(toJson(result));
+    }
+
+    //==============================================================================
+    //Same input through a float and a double processor, output difference relative to the output in dB
+    double measureFloatResidual(const std::function<void(QuadRoughAudioProcessor&)>& setup, double sampleRate, double seconds)
+    {
+        const int blockSize = 512;
+        const int numBlocks = juce::jmax(8, (int)(seconds * sampleRate / blockSize));
+
+        QuadRoughAudioProcessor single, twice;
+        setup(single);
+        setup(twice);
+
+        single.setProcessingPrecision(juce::AudioProcessor::singlePrecision);
+        twice.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+        for (auto* processor : { &single, &twice }) {
+
+            processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor->prepareToPlay(sampleRate, blockSize);
+        }
+
+        juce::AudioBuffer<double> input(2, blockSize), output(2, blockSize);
+        juce::AudioBuffer<float> floatOutput(2, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1234);
+        double phase = 0.0, signal = 0.0, residual = 0.0;
+
+        for (int block = 0; block < numBlocks; block++) {
+
+            fillInput(input, random, phase, juce::MathConstants<double>::twoPi * 220.0 / sampleRate);
+
+            output.makeCopyOf(input);
+            floatOutput.makeCopyOf(input);
+            twice.processBlock(output, midi);
+            single.processBlock(floatOutput, midi);
+
+            //Skips the first blocks, while the smoothers settle
+            if (block < numBlocks / 4)
+                continue;
+
+            for (int channel = 0; channel < 2; channel++) {
+
+                for (int i = 0; i < blockSize; i++) {
+
+                    double reference = output.getSample(channel, i);
+                    double difference = (double)floatOutput.getSample(channel, i) - reference;
+                    signal += reference * reference;
+                    residual += difference * difference;
+                }
+            }
+        }
+
+        single.releaseResources();
+        twice.releaseResources();
+
+        return 10.0 * std::log10(juce::jmax(residual, 1.0e-30) / juce::jmax(signal, 1.0e-30));
+    }
+
+    //Float against double: CPU of every algorithm, and the noise floor of the float path measured
+    //against the double one, filters only and with the distortion
+    void runPrecisionSuite(const Settings& settings, juce::StringArray& output)
+    {
+        const char* algorithms[] = { "CLASSIC", "PRISTINE", "HARD", "MAD" };
+        const double sampleRate = 48000.0;
+
+        for (int algorithm = 0; algorithm < 4; algorithm++) {
+
+            for (int precision = 0; precision < 2; precision++) {
+
+                for (auto blockSize : settings.blockSizes) {
+
+                    QuadRoughAudioProcessor processor;
+                    setParameter(processor, "DRIVE", 12.0f);
+                    setParameter(processor, "TONE", 6.0f);
+                    setParameter(processor, "DISTTYPE", (float)algorithm);
+
+                    Result result;
+                    result.suite = "precision";
+                    result.name = juce::String(algorithms[algorithm]) + (precision ? " double" : " float");
+                    result.fields.set("algorithm", "\"" + juce::String(algorithms[algorithm]) + "\"");
+                    result.fields.set("precision", precision ? "\"double\"" : "\"float\"");
+
+                    if (precision)
+                        measure<double>(processor, sampleRate, blockSize, settings.seconds, result);
+                    else
+                        measure<float>(processor, sampleRate, blockSize, settings.seconds, result);
+
+                    output.add(toJson(result));
+                }
+            }
+        }
+
+        //TONE at both ends with DRYWET at 0, then every algorithm fully wet
+        for (float tone : { -12.0f, 12.0f }) {
+
+            Result result;
+            result.suite = "precision";
+            result.name = "noise floor filters TONE " + juce::String(tone, 0);
+            result.fields.set("residualDb", juce::String(measureFloatResidual([tone](QuadRoughAudioProcessor& processor) {
+                setParameter(processor, "DRYWET", 0.0f);
+                setParameter(processor, "TONE", tone);
+            }, sampleRate, settings.seconds), 1));
+            output.add(toJson(result));
+        }
+
+        for (int algorithm = 0; algorithm < 4; algorithm++) {
+
+            Result result;
+            result.suite = "precision";
+            result.name = "noise floor " + juce::String(algorithms[algorithm]);
+            result.fields.set("algorithm", "\"" + juce::String(algorithms[algorithm]) + "\"");
+            result.fields.set("residualDb", juce::String(measureFloatResidual([algorithm](QuadRoughAudioProcessor& processor) {
+                setParameter(processor, "DRIVE", 12.0f);
+                setParameter(processor, "TONE", 6.0f);
+                setParameter(processor, "DISTTYPE", (float)algorithm);
+            }, sampleRate, settings.seconds), 1));
+            output.add(toJson(result));
+        }
+    }
+
+    //==============================================================================
+    //Surround and ambisonic buses, the channel groups on the audio thread alone and on the worker pool
+    void runSurroundSuite(const Settings& settings, juce::StringArray& output)
+    {
+        const std::pair<const char*, juce::AudioChannelSet> layouts[] = {
+            { "5.1", juce::AudioChannelSet::create5point1() },
+            { "7.1.4", juce::AudioChannelSet::create7point1point4() },
+            { "ambisonic 3", juce::AudioChannelSet::ambisonic(3) },
+        };
+
+        for (auto& layout : layouts) {
+
+            for (int pool = 0; pool < 2; pool++) {
+
+                for (auto blockSize : settings.blockSizes) {
+
+                    QuadRoughAudioProcessor processor;
+                    setParameter(processor, "DRIVE", 12.0f);
+                    setParameter(processor, "TONE", 6.0f);
+                    setParameter(processor, "MIDSIDE", 1.0f);
+                    setParameter(processor, "OVERSAMPLING", 1.0f);
+
+                    juce::AudioProcessor::BusesLayout buses;
+                    buses.inputBuses.add(layout.second);
+                    buses.outputBuses.add(layout.second);
+
+                    if (!processor.setBusesLayout(buses))
+                        continue;
+
+                    processor.setMaxWorkerThreads(pool ? -1 : 0);
+
+                    Result result;
+                    result.suite = "surround";
+                    result.name = juce::String(layout.first) + (pool ? " pool" : " serial");
+                    result.fields.set("layout", "\"" + juce::String(layout.first) + "\"");
+                    result.fields.set("channels", juce::String(layout.second.size()));
+
+                    measure(processor, 48000.0, blockSize, settings.seconds, result);
+
+                    result.fields.set("groups", juce::String(processor.getNumChannelGroups()));
+                    result.fields.set("parallel", pool && blockSize >= QuadRoughAudioProcessor::parallelBlockSize ? "true" : "false");
+                    output.add(toJson(result));
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    //--check: what the suites only measure, asserted. Every check returns an empty string
+    //when it passes, otherwise what went wrong
+
+    //Allocations of processBlock over numBlocks blocks after one warm up block.
+    //beforeBlock(index) runs before every counted block, outside the count
+    template <typename SampleType = float>
+    long long countAllocations(QuadRoughAudioProcessor& processor, double sampleRate, int blockSize, int numBlocks,
+                               const std::function<void(int)>& beforeBlock)
+    {
+        processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                   : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<SampleType> buffer(juce::jmax(1, processor.getTotalNumInputChannels()), blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1234);
+        double phase = 0.0;
+        long long allocations = 0;
+
+        fillInput(buffer, random, phase, juce::MathConstants<double>::twoPi * 220.0 / sampleRate);
+        processor.processBlock(buffer, midi);
+
+        for (int block = 0; block < numBlocks; block++) {
+
+            fillInput(buffer, random, phase, juce::MathConstants<double>::twoPi * 220.0 / sampleRate);
+            beforeBlock(block);
+
+            AllocationCounter counter;
+            processor.processBlock(buffer, midi);
+            allocations += counter.get();
+        }
+
+        processor.releaseResources();
+        return allocations;
+    }
+
+    juce::String describeAllocations(long long allocations, const juce::String& context)
+    {
+        return allocations == 0 ? juce::String() : juce::String(allocations) + " allocations in processBlock " + context;
+    }
+
+    //TONE between its ends at every block: the smoother moves it in every sub-block and the
+    //ten filters are redesigned in place each time, in float and in double
+    juce::String checkToneSweep()
+    {
+        for (bool doublePrecision : { false, true }) {
+
+            QuadRoughAudioProcessor processor;
+            auto sweep = [&processor](int block) { setParameter(processor, "TONE", block % 2 == 0 ? 20.0f : -20.0f); };
+
+            const auto allocations = doublePrecision ? countAllocations<double>(processor, 48000.0, 512, 64, sweep)
+                                                     : countAllocations<float>(processor, 48000.0, 512, 64, sweep);
+
+            auto failure = describeAllocations(allocations, doublePrecision ? "sweeping TONE in double" : "sweeping TONE");
+
+            if (failure.isNotEmpty())
+                return failure;
+        }
+
+        return {};
+    }
+
+    //Every parameter at a random value before every block, choices and buttons included:
+    //the snapshot reads them through the handles cached at construction
+    juce::String checkParameterSnapshot()
+    {
+        QuadRoughAudioProcessor processor;
+        juce::Random random(4321);
+
+        const auto allocations = countAllocations(processor, 48000.0, 512, 256, [&processor, &random](int) {
+            for (auto* parameter : processor.getParameters())
+                parameter->setValueNotifyingHost(random.nextFloat());
+        });
+
+        return describeAllocations(allocations, "with every parameter changing");
+    }
+
+    //IN, OUT, DRIVE, DRYWET and TONE jumping between their ends at every block, with host blocks
+    //shorter than, across and longer than the sub-blocks the ramps are computed for
+    juce::String checkSmoothing()
+    {
+        for (int blockSize : { 1, 17, 33, 512, 4096 }) {
+
+            QuadRoughAudioProcessor processor;
+
+            const auto allocations = countAllocations(processor, 48000.0, blockSize, 64, [&processor](int block) {
+                const bool high = block % 2 == 0;
+                setParameter(processor, "IN", high ? 12.0f : -12.0f);
+                setParameter(processor, "OUT", high ? -12.0f : 12.0f);
+                setParameter(processor, "DRIVE", high ? 20.0f : 0.0f);
+                setParameter(processor, "DRYWET", high ? 0.0f : 100.0f);
+                setParameter(processor, "TONE", high ? 20.0f : -20.0f);
+            });
+
+            auto failure = describeAllocations(allocations, "smoothing with " + juce::String(blockSize) + " sample blocks");
+
+            if (failure.isNotEmpty())
+                return failure;
+        }
+
+        return {};
+    }
+
+    //A factory preset selected before every block, on the message thread: the parameters reach
+    //the values of the preset and processBlock neither allocates nor applies anything
+    juce::String checkPresetSwitch()
+    {
+        QuadRoughAudioProcessor processor;
+        const int numPresets = processor.getNumPrograms();
+        int init = -1, warmBus = -1;
+
+        for (int index = 0; index < numPresets; index++) {
+
+            if (processor.getProgramName(index) == "Init")
+                init = index;
+            else if (processor.getProgramName(index) == "Warm Bus")
+                warmBus = index;
+        }
+
+        if (init < 0 || warmBus < 0)
+            return "no Init or Warm Bus preset";
+
+        juce::String wrongValue;
+
+        const auto allocations = countAllocations(processor, 48000.0, 512, 4 * numPresets, [&](int block) {
+            const int index = block % numPresets;
+            processor.setCurrentProgram(index);
+
+            const float drive = processor.apvts.getRawParameterValue("DRIVE")->load();
+            const float expected = index == warmBus ? 6.0f : index == init ? 0.0f : drive;
+
+            if (!juce::approximatelyEqual(drive, expected) && wrongValue.isEmpty())
+                wrongValue = "DRIVE is " + juce::String(drive) + " after " + processor.getProgramName(index);
+        });
+
+        return wrongValue.isNotEmpty() ? wrongValue : describeAllocations(allocations, "switching presets");
+    }
+
+    //Largest value of samples[first, last) and of the points 1/4, 1/2 and 3/4 of the way to the next
+    //sample, interpolated with a 128 tap windowed sinc: the 4x true peak, more exact than the limiter
+    double measureTruePeak(const std::vector<float>& samples, int first, int last)
+    {
+        constexpr int halfLength = 64;
+        double peak = 0.0;
+
+        for (int n = juce::jmax(first, halfLength); n < juce::jmin(last, (int)samples.size() - halfLength); n++) {
+
+            peak = juce::jmax(peak, std::abs((double)samples[(size_t)n]));
+
+            for (int phase = 1; phase < 4; phase++) {
+
+                const double position = n + phase / 4.0;
+                double value = 0.0;
+
+                for (int k = n - halfLength + 1; k <= n + halfLength; k++)
+                {
+                    const double t = position - k;
+                    const double x = juce::MathConstants<double>::pi * t / halfLength;
+                    const double window = 0.42 + 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+                    value += samples[(size_t)k] * window * std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+                }
+
+                peak = juce::jmax(peak, std::abs(value));
+            }
+        }
+
+        return peak;
+    }
+
+    //A sine at a quarter of the samplerate, 45 degrees off its peaks: every sample is at the ceiling
+    //and the true peak is 3 dB above. The limiter must bring the true peak of its output under the
+    //ceiling, at every lookahead, although the sample peak alone would not ask for any limiting
+    juce::String checkCeilingTruePeak()
+    {
+        const double sampleRate = 48000.0;
+        const int numSamples = 16384, blockSize = 512;
+
+        for (int lookahead = 0; lookahead < CeilingLimiter::numLookaheads; lookahead++) {
+
+            CeilingLimiter limiter;
+            limiter.prepare(sampleRate, 2);
+            limiter.setLookahead(lookahead);
+            limiter.reset();
+
+            std::vector<float> left((size_t)numSamples), right((size_t)numSamples);
+
+            for (int n = 0; n < numSamples; n++) {
+
+                const double phase = juce::MathConstants<double>::pi * (n * 0.5 + 0.25);
+                left[(size_t)n] = right[(size_t)n] = (float)(CeilingLimiter::ceiling * std::sqrt(2.0) * std::sin(phase));
+            }
+
+            for (int start = 0; start < numSamples; start += blockSize) {
+
+                float* channels[] = { left.data() + start, right.data() + start };
+                juce::dsp::AudioBlock<float> block(channels, 2, (size_t)blockSize);
+                limiter.process(block, 1.0f, 1.0f);
+            }
+
+            //From the delayed start of the sine, once the gain has come down
+            const double truePeak = measureTruePeak(left, limiter.getLatencyInSamples() + 256, numSamples);
+
+            if (truePeak > CeilingLimiter::ceiling)
+                return "true peak " + juce::String(juce::Decibels::gainToDecibels(truePeak), 3) + " dBFS with lookahead " + juce::String(lookahead);
+        }
+
+        return {};
+    }
+
+    //Peak of the right channel over the peak of the left, for an impulse panned hard left through
+    //the chain with the parameters already set. With MIDSIDE the decode only cancels on the right
+    //when Mid and Side come out of the shaper stage with the same delay
+    float measureCrosstalk(QuadRoughAudioProcessor& processor, double sampleRate)
+    {
+        constexpr int blockSize = 512, numBlocks = 8;
+
+        processor.setProcessingPrecision(juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        float left = 0.0f, right = 0.0f;
+
+        for (int block = 0; block < numBlocks; block++) {
+
+            buffer.clear();
+
+            if (block == 0)
+                buffer.setSample(0, 100, 0.5f);
+
+            processor.processBlock(buffer, midi);
+            left = juce::jmax(left, buffer.getMagnitude(0, 0, blockSize));
+            right = juce::jmax(right, buffer.getMagnitude(1, 0, blockSize));
+        }
+
+        processor.releaseResources();
+        return left > 0.0f ? right / left : 1.0f;
+    }
+
+    //MIDSIDE with ADAA1 and ADAA2, fully dry, with and without oversampling: Mid is delayed by the
+    //shaper, Side must be delayed alike or a hard panned source leaks into the other channel
+    juce::String checkMidSideAdaa()
+    {
+        for (int quality : { 1, 2 }) {
+
+            for (int oversampling : { 0, 1 }) {
+
+                QuadRoughAudioProcessor processor;
+                setParameter(processor, "MIDSIDE", 1.0f);
+                setParameter(processor, "DRYWET", 0.0f);
+                setParameter(processor, "QUALITY", (float)quality);
+                setParameter(processor, "OVERSAMPLING", (float)oversampling);
+
+                const float crosstalk = measureCrosstalk(processor, 48000.0);
+
+                if (crosstalk > 1.0e-5f)
+                    return "crosstalk " + juce::String(juce::Decibels::gainToDecibels(crosstalk), 1) + " dB with ADAA" + juce::String(quality)
+                         + " at " + juce::String(1 << oversampling) + "x";
+            }
+        }
+
+        return {};
+    }
+
+    //MIDSIDE with 2 bands and DRIVE at 0 dB, the bands on HARD where it is the identity below the
+    //threshold: Mid goes through the allpass of the crossover, Side must too or the decode smears
+    //a hard panned source into the other channel. Also with ADAA1 and ADAA2, fully dry
+    juce::String checkMidSideBands()
+    {
+        struct Setting { int quality; float drywet; };
+
+        for (auto setting : { Setting { 0, 100.0f }, Setting { 1, 0.0f }, Setting { 2, 0.0f } }) {
+
+            for (int oversampling : { 0, 1 }) {
+
+                QuadRoughAudioProcessor processor;
+                setParameter(processor, "MIDSIDE", 1.0f);
+                setParameter(processor, "BANDS", 1.0f);
+                setParameter(processor, "BAND1TYPE", 2.0f);
+                setParameter(processor, "BAND2TYPE", 2.0f);
+                setParameter(processor, "DRYWET", setting.drywet);
+                setParameter(processor, "QUALITY", (float)setting.quality);
+                setParameter(processor, "OVERSAMPLING", (float)oversampling);
+
+                const float crosstalk = measureCrosstalk(processor, 48000.0);
+
+                if (crosstalk > 1.0e-5f)
+                    return "crosstalk " + juce::String(juce::Decibels::gainToDecibels(crosstalk), 1) + " dB with QUALITY " + juce::String(setting.quality)
+                         + " at " + juce::String(1 << oversampling) + "x";
+            }
+        }
+
+        return {};
+    }
+
+    struct Check
+    {
+        const char* name;
+        juce::String (*run)();
+    };
+
+    const Check checks[] = {
+        { "tone sweep allocations", checkToneSweep },
+        { "parameter snapshot allocations", checkParameterSnapshot },
+        { "smoothing allocations", checkSmoothing },
+        { "preset switch", checkPresetSwitch },
+        { "ceiling true peak", checkCeilingTruePeak },
+        { "mid side ADAA alignment", checkMidSideAdaa },
+        { "mid side multiband alignment", checkMidSideBands },
+    };
+
+    //Runs every check, prints one line each. Returns the exit code: 1 if any failed
+    int runChecks()
+    {
+        int failures = 0;
+
+        for (const auto& check : checks) {
+
+            const auto failure = check.run();
+
+            if (failure.isEmpty()) {
+                std::printf("PASS %s\n", check.name);
+            }
+            else {
+                std::printf("FAIL %s: %s\n", check.name, failure.toRawUTF8());
+                failures++;
+            }
+        }
+
+        std::printf("%d of %d checks failed\n", failures, (int)std::size(checks));
+        return failures > 0 ? 1 : 0;
+    }
+
+    //==============================================================================
+    juce::Array<int> parseIntegers(const juce::String& list)
+    {
+        juce::Array<int> values;
+
+        for (auto& token : juce::StringArray::fromTokens(list, ",", ""))
+            values.add(token.getIntValue());
+
+        return values;
+    }
+
+    void printUsage()
+    {
+        std::printf("quadrough_bench [--suite all|chain|antialiasing|multiband|kernels|state|precision|surround] [--seconds s]\n"
+                    "                [--rates 44100,48000] [--blocks 64,512] [--budget percent] [--quick] [--output file.json]\n"
+                    "quadrough_bench --check\n");
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    Settings settings;
+
+    for (int i = 1; i < argc; i++) {
+
+        juce::String argument(argv[i]);
+        juce::String value = i + 1 < argc ? juce::String(argv[i + 1]) : juce::String();
+
+        if (argument == "--suite") {
+            settings.suite = value;
+            i++;
+        }
+        else if (argument == "--seconds") {
+            settings.seconds = value.getDoubleValue();
+            i++;
+        }
+        else if (argument == "--rates") {
+            settings.sampleRates.clear();
+
+            for (auto rate : parseIntegers(value))
+                settings.sampleRates.add((double)rate);
+
+            i++;
+        }
+        else if (argument == "--blocks") {
+            settings.blockSizes = parseIntegers(value);
+            i++;
+        }
+        else if (argument == "--budget") {
+            settings.budgetPercent = value.getDoubleValue();
+            i++;
+        }
+        else if (argument == "--quick") {
+            settings.sampleRates = { 48000.0 };
+            settings.blockSizes = { 64, 512, 4096 };
+            settings.seconds = 0.25;
+        }
+        else if (argument == "--output") {
+            settings.outputFile = value;
+            i++;
+        }
+        else if (argument == "--check") {
+            settings.check = true;
+        }
+        else {
+            printUsage();
+            return argument == "--help" ? 0 : 1;
+        }
+    }
+
+    //Pass or fail instead of measurements, for ctest
+    if (settings.check)
+        return runChecks();
+
+    juce::StringArray results;
+
+    if (settings.suite == "all" || settings.suite == "chain")
+        runChainSuite(settings, results);
+
+    if (settings.suite == "all" || settings.suite == "antialiasing")
+        runAntiAliasingSuite(settings, results);
+
+    if (settings.suite == "all" || settings.suite == "multiband")
+        runMultibandSuite(settings, results);
+
+    if (settings.suite == "all" || settings.suite == "kernels")
+        runKernelSuite(settings, results);
+
+    if (settings.suite == "all" || settings.suite == "state")
+        runStateSuite(settings, results);
+
+    if (settings.suite == "all" || settings.suite == "precision")
+        runPrecisionSuite(settings, results);
+
+    if (settings.suite == "all" || settings.suite == "surround")
+        runSurroundSuite(settings, results);
+
+    juce::String json;
+    json << "{\n  \"cpu\": \"" << juce::SystemStats::getCpuModel() << "\",\n"
+         << "  \"shaperKernels\": \"" << ShaperKernels::getBest().name << "\",\n"
+         << "  \"profiling\": " << (QUADROUGH_PROFILING ? "true" : "false") << ",\n"
+         << "  \"results\": [\n    " << results.joinIntoString(",\n    ") << "\n  ]\n}\n";
+
+    if (settings.outputFile.isNotEmpty()) {
+
+        juce::File file = juce::File::getCurrentWorkingDirectory().getChildFile(settings.outputFile);
+
+        if (!file.replaceWithText(json)) {
+            std::fprintf(stderr, "Cannot write %s\n", file.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+    else {
+        std::fputs(json.toRawUTF8(), stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,546 @@
+/*
+  ==============================================================================
+
+    QuadRoughRender.cpp
+
+    quadrough-render: offline rendering of audio files through the processor.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+#include <atomic>
+#include <cstdio>
+#include <iterator>
+
+namespace
+{
+    //==============================================================================
+    struct RenderSettings
+    {
+        juce::File preset;
+        juce::StringArray overrides;
+        juce::File outputDirectory;
+        juce::Array<juce::File> inputs;
+        int blockSize = 16384;
+        int numWorkers = juce::SystemStats::getNumCpus();
+        bool overwrite = false;
+        bool selfTest = false;
+
+        //Threads of each processor for its channel groups, on top of the file workers
+        int groupThreads = 0;
+    };
+
+    //Files handed out to the workers, and the results
+    struct RenderQueue
+    {
+        juce::Array<juce::File> files;
+        std::atomic<int> next { 0 };
+        std::atomic<int> numFailed { 0 };
+
+        juce::CriticalSection logLock;
+
+        void log(const juce::String& message)
+        {
+            const juce::ScopedLock lock(logLock);
+            std::printf("%s\n", message.toRawUTF8());
+            std::fflush(stdout);
+        }
+    };
+
+    //==============================================================================
+    //PARAMETER=value, the value in the parameter units or the name of a choice
+    bool applyOverride(QuadRoughAudioProcessor& processor, const juce::String& assignment)
+    {
+        auto id = assignment.upToFirstOccurrenceOf("=", false, false).trim().toUpperCase();
+        auto value = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+        auto* parameter = processor.apvts.getParameter(id);
+
+        if (parameter == nullptr || value.isEmpty())
+            return false;
+
+        float number = value.getFloatValue();
+
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter)) {
+
+            int index = choice->choices.indexOf(value, true);
+
+            if (index >= 0)
+                number = (float)index;
+        }
+
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(number));
+        return true;
+    }
+
+    //Preset: the parameters XML, or the binary state saved by the plugin
+    bool loadPreset(QuadRoughAudioProcessor& processor, const juce::File& file)
+    {
+        if (auto xml = juce::parseXML(file)) {
+
+            if (!xml->hasTagName(processor.apvts.state.getType()))
+                return false;
+
+            processor.apvts.replaceState(juce::ValueTree::fromXml(*xml));
+            return true;
+        }
+
+        juce::MemoryBlock data;
+
+        if (!file.loadFileAsData(data))
+            return false;
+
+        if (!PluginState::isBinaryState(data.getData(), (int)data.getSize())
+            && juce::AudioProcessor::getXmlFromBinary(data.getData(), (int)data.getSize()) == nullptr)
+            return false;
+
+        processor.setStateInformation(data.getData(), (int)data.getSize());
+        return true;
+    }
+
+    //==============================================================================
+    /**
+        One worker thread with its own processor, taking files from the queue
+        until it is empty.
+
+        The input is memory mapped when the format allows it (WAV, AIFF) and read
+        through a stream otherwise (FLAC). The output goes to a ThreadedWriter, so
+        the worker only converts samples into its FIFO and the disk writes happen
+        on the shared writer thread.
+    */
+    class RenderJob : public juce::ThreadPoolJob
+    {
+    public:
+        RenderJob(RenderQueue& q, const RenderSettings& s, juce::AudioFormatManager& formats,
+                  juce::TimeSliceThread& writer, const juce::MemoryBlock& state)
+            : juce::ThreadPoolJob("quadrough-render"), queue(q), settings(s), formatManager(formats), writerThread(writer)
+        {
+            //Created on the message thread, only processBlock runs on the worker
+            processor.setStateInformation(state.getData(), (int)state.getSize());
+            processor.setNonRealtime(true);
+            processor.setMaxWorkerThreads(settings.groupThreads);
+        }
+
+        JobStatus runJob() override
+        {
+            for (int index = queue.next++; index < queue.files.size() && !shouldExit(); index = queue.next++) {
+
+                auto& input = queue.files.getReference(index);
+                auto error = render(input);
+
+                if (error.isEmpty()) {
+                    queue.log("rendered " + input.getFullPathName());
+                }
+                else {
+                    queue.numFailed++;
+                    queue.log("failed   " + input.getFullPathName() + ": " + error);
+                }
+            }
+
+            return jobHasFinished;
+        }
+
+    private:
+        //Returns an error message, empty on success
+        juce::String render(const juce::File& input)
+        {
+            auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+
+            if (format == nullptr)
+                return "unsupported format";
+
+            //Zero copy input when the format can be mapped, streamed otherwise
+            std::unique_ptr<juce::AudioFormatReader> reader;
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(input));
+
+            if (mapped != nullptr && mapped->mapEntireFile())
+                reader = std::move(mapped);
+            else
+                reader.reset(format->createReaderFor(input.createInputStream().release(), true));
+
+            if (reader == nullptr)
+                return "cannot read the file";
+
+            const int numChannels = (int)reader->numChannels;
+
+            if (numChannels < 1 || numChannels > ChannelGroup::maxChannels)
+                return "only files of 1 to " + juce::String(ChannelGroup::maxChannels) + " channels are supported";
+
+            auto output = settings.outputDirectory.getChildFile(input.getFileName());
+
+            if (output == input)
+                return "the output would replace the input";
+
+            if (output.exists() && !settings.overwrite)
+                return "output exists, use --overwrite";
+
+            output.deleteFile();
+
+            auto stream = output.createOutputStream();
+
+            if (stream == nullptr)
+                return "cannot create " + output.getFullPathName();
+
+            std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader->sampleRate, (unsigned int)numChannels,
+                                                                                    (int)reader->bitsPerSample, reader->metadataValues, 0));
+
+            if (writer == nullptr)
+                return "cannot write this format";
+
+            stream.release();
+
+            //The FIFO holds a few blocks, the writer thread empties it
+            juce::AudioFormatWriter::ThreadedWriter threadedWriter(writer.release(), writerThread, settings.blockSize * 4);
+
+            return process(*reader, threadedWriter, numChannels);
+        }
+
+        juce::String process(juce::AudioFormatReader& reader, juce::AudioFormatWriter::ThreadedWriter& writer, int numChannels)
+        {
+            const int blockSize = settings.blockSize;
+            //Mono, stereo, the usual surround layout of the channel count or discrete channels
+            const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add(channelSet);
+            layout.outputBuses.add(channelSet);
+
+            if (!processor.setBusesLayout(layout))
+                return "unsupported channel layout";
+
+            processor.setRateAndBufferSizeDetails(reader.sampleRate, blockSize);
+            processor.prepareToPlay(reader.sampleRate, blockSize);
+
+            //The first latency samples are dropped and the end is flushed with silence,
+            //so the output lines up with the input and has the same length
+            const juce::int64 length = reader.lengthInSamples;
+            const int latency = processor.getLatencySamples();
+            const juce::int64 total = length + latency;
+
+            juce::AudioBuffer<float> buffer(numChannels, blockSize);
+            juce::MidiBuffer midi;
+            int toSkip = latency;
+
+            for (juce::int64 position = 0; position < total && !shouldExit(); position += blockSize) {
+
+                const int numSamples = (int)juce::jmin((juce::int64)blockSize, total - position);
+                const int numRead = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, length - position);
+
+                if (numSamples != buffer.getNumSamples())
+                    buffer.setSize(numChannels, numSamples, false, false, true);
+
+                if (numRead > 0 && !reader.read(&buffer, 0, numRead, position, true, true))
+                    return "read error";
+
+                if (numRead < numSamples)
+                    buffer.clear(numRead, numSamples - numRead);
+
+                processor.processBlock(buffer, midi);
+
+                const int skip = juce::jmin(toSkip, numSamples);
+                toSkip -= skip;
+
+                if (skip < numSamples) {
+
+                    std::array<const float*, ChannelGroup::maxChannels> channels {};
+
+                    for (int channel = 0; channel < numChannels; channel++)
+                        channels[(size_t)channel] = buffer.getReadPointer(channel, skip);
+
+                    //Waits for the writer thread when the FIFO is full
+                    while (!writer.write(channels.data(), numSamples - skip))
+                        juce::Thread::sleep(1);
+                }
+            }
+
+            processor.releaseResources();
+            return {};
+        }
+
+        RenderQueue& queue;
+        const RenderSettings& settings;
+        juce::AudioFormatManager& formatManager;
+        juce::TimeSliceThread& writerThread;
+
+        QuadRoughAudioProcessor processor;
+
+        JUCE_DECLARE_NON_COPYABLE(RenderJob)
+    };
+
+    //==============================================================================
+    void addInputs(const juce::File& path, const juce::AudioFormatManager& formats, juce::Array<juce::File>& inputs)
+    {
+        if (path.isDirectory()) {
+
+            auto files = path.findChildFiles(juce::File::findFiles, false, formats.getWildcardForAllFormats());
+            files.sort();
+            inputs.addArray(files);
+        }
+        else {
+            inputs.add(path);
+        }
+    }
+
+    //Settings of every worker, taken from one processor. Returns an error message, empty on success
+    juce::String createState(const RenderSettings& settings, juce::MemoryBlock& state)
+    {
+        QuadRoughAudioProcessor processor;
+
+        if (settings.preset != juce::File() && !loadPreset(processor, settings.preset))
+            return "Cannot load the preset " + settings.preset.getFullPathName();
+
+        for (auto& assignment : settings.overrides) {
+
+            if (!applyOverride(processor, assignment))
+                return "Invalid parameter " + assignment;
+        }
+
+        processor.getStateInformation(state);
+        return {};
+    }
+
+    //Renders every input with the state, returns the number of files that failed
+    int renderFiles(RenderSettings& settings, juce::AudioFormatManager& formatManager, const juce::MemoryBlock& state)
+    {
+        RenderQueue queue;
+        queue.files = settings.inputs;
+
+        //One thread writes every output, the workers only fill its FIFOs
+        juce::TimeSliceThread writerThread("quadrough-render writer");
+        writerThread.startThread();
+
+        const int numWorkers = juce::jmin(settings.numWorkers, settings.inputs.size());
+        juce::ThreadPool pool(numWorkers);
+
+        //Fewer files than cores: the channel groups of each file share the idle cores
+        settings.groupThreads = juce::jmax(0, juce::SystemStats::getNumCpus() / numWorkers - 1);
+        juce::OwnedArray<RenderJob> jobs;
+
+        for (int i = 0; i < numWorkers; i++)
+            pool.addJob(jobs.add(new RenderJob(queue, settings, formatManager, writerThread, state)), false);
+
+        for (auto* job : jobs)
+            pool.waitForJobToFinish(job, -1);
+
+        //Pending writes are flushed by the ThreadedWriter destructors, inside the jobs
+        writerThread.stopThread(5000);
+
+        std::printf("%d of %d files rendered\n", queue.files.size() - queue.numFailed.load(), queue.files.size());
+        return queue.numFailed.load();
+    }
+
+    //==============================================================================
+    /**
+        Round trip of an impulse through the whole renderer: a WAV file written to a
+        temporary folder, rendered at neutral settings and read back.
+
+        The output must have the length of the input and the impulse on the same
+        sample, with the latency of the render mode (8x linear phase oversampling)
+        and with the one of the ceiling lookahead on top. At 44.1 kHz the safety
+        filters leave the peak of an impulse on its sample, so any error in the
+        latency compensation or in the flush of the end moves or loses it.
+    */
+    int runSelfTest(const RenderSettings& defaults, juce::AudioFormatManager& formatManager)
+    {
+        constexpr double sampleRate = 44100.0;
+        constexpr int numChannels = 2;
+
+        //A few blocks and a partial one, the impulse in the last block so it only comes out with the flush
+        const int length = 3 * defaults.blockSize + 1234;
+        const int impulsePosition = length - 100;
+
+        auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("quadrough-render-self-test", {}, false);
+
+        if (!directory.createDirectory()) {
+            std::fprintf(stderr, "Cannot create %s\n", directory.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        auto input = directory.getChildFile("impulse.wav");
+        {
+            juce::AudioBuffer<float> impulse(numChannels, length);
+            impulse.clear();
+
+            for (int channel = 0; channel < numChannels; channel++)
+                impulse.setSample(channel, impulsePosition, 0.5f);
+
+            juce::WavAudioFormat wav;
+            auto stream = input.createOutputStream();
+            std::unique_ptr<juce::AudioFormatWriter> writer(stream != nullptr ? wav.createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels, 24, {}, 0) : nullptr);
+
+            if (writer == nullptr) {
+                std::fprintf(stderr, "Cannot write %s\n", input.getFullPathName().toRawUTF8());
+                directory.deleteRecursively();
+                return 1;
+            }
+
+            stream.release();
+            writer->writeFromAudioSampleBuffer(impulse, 0, length);
+        }
+
+        //Default settings are neutral: DRIVE 0 dB, TONE 0 dB, fully wet
+        const std::pair<const char*, const char*> configurations[] = {
+            { "render mode", nullptr },
+            { "render mode and ceiling", "CLIPPER=1" }
+        };
+
+        int numFailed = 0;
+
+        for (auto& configuration : configurations) {
+
+            RenderSettings settings = defaults;
+            settings.inputs.clearQuick();
+            settings.inputs.add(input);
+            settings.outputDirectory = directory.getChildFile(juce::String(configuration.first).replaceCharacter(' ', '_'));
+            settings.overrides.clear();
+            settings.preset = juce::File();
+            settings.numWorkers = 1;
+            settings.overwrite = true;
+
+            if (configuration.second != nullptr)
+                settings.overrides.add(configuration.second);
+
+            juce::String failure;
+            juce::MemoryBlock state;
+
+            if (!settings.outputDirectory.createDirectory())
+                failure = "cannot create " + settings.outputDirectory.getFullPathName();
+            else
+                failure = createState(settings, state);
+
+            if (failure.isEmpty() && renderFiles(settings, formatManager, state) != 0)
+                failure = "the render failed";
+
+            std::unique_ptr<juce::AudioFormatReader> reader;
+
+            if (failure.isEmpty()) {
+
+                reader.reset(formatManager.createReaderFor(settings.outputDirectory.getChildFile(input.getFileName())));
+
+                if (reader == nullptr)
+                    failure = "cannot read the output";
+                else if (reader->lengthInSamples != length)
+                    failure = "output of " + juce::String(reader->lengthInSamples) + " samples, input of " + juce::String(length);
+                else if ((int)reader->numChannels != numChannels)
+                    failure = "output of " + juce::String(reader->numChannels) + " channels";
+            }
+
+            if (failure.isEmpty()) {
+
+                juce::AudioBuffer<float> output(numChannels, length);
+                reader->read(&output, 0, length, 0, true, true);
+
+                for (int channel = 0; channel < numChannels && failure.isEmpty(); channel++) {
+
+                    const float* samples = output.getReadPointer(channel);
+                    int peak = 0;
+
+                    for (int i = 1; i < length; i++)
+                        if (std::abs(samples[i]) > std::abs(samples[peak]))
+                            peak = i;
+
+                    if (peak != impulsePosition)
+                        failure = "impulse at sample " + juce::String(peak) + " of channel " + juce::String(channel)
+                                + ", expected " + juce::String(impulsePosition);
+                }
+            }
+
+            if (failure.isEmpty()) {
+                std::printf("PASS %s\n", configuration.first);
+            }
+            else {
+                numFailed++;
+                std::printf("FAIL %s: %s\n", configuration.first, failure.toRawUTF8());
+            }
+        }
+
+        directory.deleteRecursively();
+
+        std::printf("%d of %d self tests failed\n", numFailed, (int)std::size(configurations));
+        return numFailed == 0 ? 0 : 1;
+    }
+
+    void printUsage()
+    {
+        std::printf("quadrough-render [options] <file or folder>...\n"
+                    "  --preset <file>      parameters XML or saved plugin state\n"
+                    "  --set ID=value       override a parameter, e.g. --set DRIVE=12 --set DISTTYPE=HARD\n"
+                    "  --output <folder>    where the rendered files are written (required)\n"
+                    "  --block <samples>    processing block size, default 16384\n"
+                    "  --jobs <n>           parallel files, default one per core\n"
+                    "  --overwrite          replace existing output files\n"
+                    "  --self-test          render an impulse and check its length and position, no other argument needed\n");
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    RenderSettings settings;
+    auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+    for (int i = 1; i < argc; i++) {
+
+        juce::String argument(argv[i]);
+        bool hasValue = i + 1 < argc;
+
+        if (argument == "--preset" && hasValue) {
+            settings.preset = workingDirectory.getChildFile(argv[++i]);
+        }
+        else if (argument == "--set" && hasValue) {
+            settings.overrides.add(argv[++i]);
+        }
+        else if (argument == "--output" && hasValue) {
+            settings.outputDirectory = workingDirectory.getChildFile(argv[++i]);
+        }
+        else if (argument == "--block" && hasValue) {
+            settings.blockSize = juce::jlimit(32, 1 << 18, juce::String(argv[++i]).getIntValue());
+        }
+        else if (argument == "--jobs" && hasValue) {
+            settings.numWorkers = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+        }
+        else if (argument == "--overwrite") {
+            settings.overwrite = true;
+        }
+        else if (argument == "--self-test") {
+            settings.selfTest = true;
+        }
+        else if (argument.startsWith("--")) {
+            printUsage();
+            return argument == "--help" ? 0 : 1;
+        }
+        else {
+            addInputs(workingDirectory.getChildFile(argument), formatManager, settings.inputs);
+        }
+    }
+
+    if (settings.selfTest)
+        return runSelfTest(settings, formatManager);
+
+    if (settings.inputs.isEmpty() || settings.outputDirectory == juce::File()) {
+        printUsage();
+        return 1;
+    }
+
+    if (!settings.outputDirectory.createDirectory()) {
+        std::fprintf(stderr, "Cannot create %s\n", settings.outputDirectory.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    juce::MemoryBlock state;
+    auto error = createState(settings, state);
+
+    if (error.isNotEmpty()) {
+        std::fprintf(stderr, "%s\n", error.toRawUTF8());
+        return 1;
+    }
+
+    return renderFiles(settings, formatManager, state) == 0 ? 0 : 1;
+}
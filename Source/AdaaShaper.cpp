@@ -0,0 +1,410 @@
+/*
+  ==============================================================================
+
+    AdaaShaper.cpp
+
+    Antiderivative anti-aliasing (ADAA) versions of the four algorithms.
+
+  ==============================================================================
+*/
+
+#include "AdaaShaper.h"
+
+namespace
+{
+    //Below these input differences the quotients are ill conditioned
+    const double firstOrderTolerance = 1.0e-5;
+    const double secondOrderTolerance = 1.0e-4;
+
+    const double ln2 = 0.693147180559945309;
+    const double piSquared = 9.86960440108935862;
+
+    //log(cosh(v)), without overflow for large |v|
+    double logCosh(double v)
+    {
+        double a = std::abs(v);
+        return a - ln2 + std::log1p(std::exp(-2.0 * a));
+    }
+
+    //Integral of log(cosh(v)) from 0, closed form through the dilogarithm:
+    //v^2/2 - v ln2 + Li2(-e^(-2v))/2 + pi^2/24 for v >= 0, odd.
+    //Li2(-e^(-2v)) = -Li2(w) - u^2/2 with u = log(1 + e^(-2v)), w = 1 - e^(-u),
+    //and Li2(w) comes from its Bernoulli series in u (u <= ln2, error < 1e-13)
+    double logCoshIntegral(double v)
+    {
+        double a = std::abs(v);
+        double u = std::log1p(std::exp(-2.0 * a));
+        double u2 = u * u;
+
+        double li2w = u * (1.0 + u * (-1.0 / 4.0 + u * (1.0 / 36.0 + u2 * (-1.0 / 3600.0 + u2 * (1.0 / 211680.0
+                    + u2 * (-1.0 / 10886400.0 + u2 * (1.0 / 526901760.0)))))));
+
+        double result = a * a * 0.5 - a * ln2 - 0.5 * li2w - 0.25 * u2 + piSquared / 24.0;
+
+        return v < 0.0 ? -result : result;
+    }
+
+    //==============================================================================
+    //PRISTINE triode curve and its antiderivatives, tabulated once per process
+    class PristineTables
+    {
+    public:
+        static const PristineTables& get()
+        {
+            static const PristineTables tables;
+            return tables;
+        }
+
+        //Fixed parameters for distortion shapes
+        static constexpr double q = -0.05;
+        static constexpr double d = 7.0;
+
+        //(v - q) / (1 - exp(-d (v - q))) + q / (1 - exp(d q))
+        static double curve(double v)
+        {
+            double w = v - q;
+
+            if (std::abs(w) < 1.0e-4)
+                return 1.0 / d + w * 0.5 + d * w * w / 12.0 + offset();
+
+            return w / (1.0 - std::exp(-d * w)) + offset();
+        }
+
+        static double slope(double v)
+        {
+            double w = v - q;
+
+            if (std::abs(w) < 1.0e-4)
+                return 0.5 + d * w / 6.0;
+
+            double e = std::exp(-d * w);
+            return (1.0 - e - w * d * e) / ((1.0 - e) * (1.0 - e));
+        }
+
+        double firstAntiderivative(double v) const
+        {
+            if (v > range) {
+                //Above the table the curve is the line v - q + offset
+                double dv = v - range;
+                return p1.back() + dv * (range - q + offset()) + dv * dv * 0.5;
+            }
+
+            if (v < -range) {
+                //Below the table the curve is the constant offset
+                return p1.front() + (v + range) * offset();
+            }
+
+            size_t i;
+            double t = locate(v, i);
+            return quinticHermite(t, p1[i], p[i], dp[i], p1[i + 1], p[i + 1], dp[i + 1]);
+        }
+
+        double secondAntiderivative(double v) const
+        {
+            if (v > range) {
+                double dv = v - range;
+                return p2.back() + p1.back() * dv + (range - q + offset()) * dv * dv * 0.5 + dv * dv * dv / 6.0;
+            }
+
+            if (v < -range) {
+                double dv = v + range;
+                return p2.front() + p1.front() * dv + offset() * dv * dv * 0.5;
+            }
+
+            size_t i;
+            double t = locate(v, i);
+            return quinticHermite(t, p2[i], p1[i], p[i], p2[i + 1], p1[i + 1], p[i + 1]);
+        }
+
+    private:
+        //Inputs are DRIVE (up to 10) times the signal, the curve is exactly linear/constant beyond
+        static constexpr double range = 48.0;
+        static constexpr double step = 1.0 / 64.0;
+
+        PristineTables()
+        {
+            size_t numPoints = (size_t)(2.0 * range / step) + 1;
+
+            p.resize(numPoints);
+            dp.resize(numPoints);
+            p1.resize(numPoints);
+            p2.resize(numPoints);
+
+            for (size_t i = 0; i < numPoints; i++) {
+
+                double v = -range + (double)i * step;
+                p[i] = curve(v);
+                dp[i] = slope(v);
+            }
+
+            //F1 from 4 point Gauss-Legendre on each step, exact to ~1e-15
+            const double nodes[] = { -0.861136311594053, -0.339981043584856, 0.339981043584856, 0.861136311594053 };
+            const double weights[] = { 0.347854845137454, 0.652145154862546, 0.652145154862546, 0.347854845137454 };
+
+            p1[0] = offset() * -range;
+            p2[0] = 0.0;
+
+            for (size_t i = 1; i < numPoints; i++) {
+
+                double centre = -range + ((double)i - 0.5) * step;
+                double integral = 0.0;
+
+                for (int n = 0; n < 4; n++)
+                    integral += weights[n] * curve(centre + nodes[n] * step * 0.5);
+
+                p1[i] = p1[i - 1] + integral * step * 0.5;
+
+                //F2 integrating the quintic Hermite of F1 exactly
+                p2[i] = p2[i - 1] + step * (0.5 * (p1[i - 1] + p1[i]) + 0.1 * step * (p[i - 1] - p[i])
+                                            + step * step / 120.0 * (dp[i - 1] + dp[i]));
+            }
+        }
+
+        static double offset() { return q / (1.0 - std::exp(d * q)); }
+
+        double locate(double v, size_t& index) const
+        {
+            double position = (v + range) / step;
+            index = juce::jmin((size_t)position, p.size() - 2);
+            return position - (double)index;
+        }
+
+        //Interpolates value, first and second derivative at both ends, error O(step^6)
+        static double quinticHermite(double t, double y0, double dy0, double ddy0, double y1, double dy1, double ddy1)
+        {
+            double t2 = t * t;
+            double t3 = t2 * t;
+            double t4 = t3 * t;
+            double t5 = t4 * t;
+
+            double h0 = 1.0 - 10.0 * t3 + 15.0 * t4 - 6.0 * t5;
+            double h1 = t - 6.0 * t3 + 8.0 * t4 - 3.0 * t5;
+            double h2 = 0.5 * t2 - 1.5 * t3 + 1.5 * t4 - 0.5 * t5;
+            double h3 = 10.0 * t3 - 15.0 * t4 + 6.0 * t5;
+            double h4 = -4.0 * t3 + 7.0 * t4 - 3.0 * t5;
+            double h5 = 0.5 * t3 - t4 + 0.5 * t5;
+
+            return h0 * y0 + h1 * step * dy0 + h2 * step * step * ddy0
+                 + h3 * y1 + h4 * step * dy1 + h5 * step * step * ddy1;
+        }
+
+        std::vector<double> p, dp, p1, p2;
+    };
+
+    //==============================================================================
+    //Curves as functions of the input x, DRIVE included
+
+    //CLASSIC: tanh(k x) with the tanh(4 / k) output compensation
+    struct ClassicCurve
+    {
+        explicit ClassicCurve(double drive) : k(drive), c(std::tanh(4.0 / drive)) {}
+
+        double f(double x) const { return c * std::tanh(k * x); }
+        double F1(double x) const { return c / k * logCosh(k * x); }
+        double F2(double x) const { return c / (k * k) * logCoshIntegral(k * x); }
+
+        double k, c;
+    };
+
+    //PRISTINE: triode curve of k x
+    struct PristineCurve
+    {
+        explicit PristineCurve(double drive) : k(drive), tables(PristineTables::get()) {}
+
+        double f(double x) const { return PristineTables::curve(k * x); }
+        double F1(double x) const { return tables.firstAntiderivative(k * x) / k; }
+        double F2(double x) const { return tables.secondAntiderivative(k * x) / (k * k); }
+
+        double k;
+        const PristineTables& tables;
+    };
+
+    //HARD: clip of k x at the fixed threshold 1
+    struct HardCurve
+    {
+        explicit HardCurve(double drive) : k(drive) {}
+
+        double f(double x) const { return juce::jlimit(-1.0, 1.0, k * x); }
+
+        double F1(double x) const
+        {
+            double v = k * x;
+            double result = std::abs(v) <= 1.0 ? v * v * 0.5 : std::abs(v) - 0.5;
+            return result / k;
+        }
+
+        double F2(double x) const
+        {
+            double v = k * x;
+            double result;
+
+            if (std::abs(v) <= 1.0)
+                result = v * v * v / 6.0;
+            else
+                result = (v > 0.0 ? 1.0 : -1.0) * (v * v * 0.5 + 1.0 / 6.0) - v * 0.5;
+
+            return result / (k * k);
+        }
+
+        double k;
+    };
+
+    //MAD: (x + sin(4 k x)) / 4
+    struct MadCurve
+    {
+        explicit MadCurve(double drive) : s(4.0 * drive) {}
+
+        double f(double x) const { return 0.25 * (x + std::sin(s * x)); }
+        double F1(double x) const { return 0.25 * (x * x * 0.5 - std::cos(s * x) / s); }
+        double F2(double x) const { return 0.25 * (x * x * x / 6.0 - std::sin(s * x) / (s * s)); }
+
+        double s;
+    };
+
+    //(F2(a) - F2(b)) / (a - b), or F1 at the midpoint when a and b are too close
+    template <typename Curve>
+    double firstDifference(const Curve& curve, double a, double b, double F2a, double F2b)
+    {
+        double diff = a - b;
+
+        if (std::abs(diff) > secondOrderTolerance)
+            return (F2a - F2b) / diff;
+
+        return curve.F1(0.5 * (a + b));
+    }
+}
+
+//==============================================================================
+void AdaaShaper::prepare(int numChannels)
+{
+    states.assign((size_t)juce::jmax(1, numChannels), ChannelState());
+
+    //Builds the tables now rather than on the audio thread
+    PristineTables::get();
+}
+
+void AdaaShaper::reset()
+{
+    std::fill(states.begin(), states.end(), ChannelState());
+}
+
+void AdaaShaper::process(juce::dsp::AudioBlock<float>& block, int algorithm, Order order, float drive, float drywet)
+{
+    if (algorithm == 0) {
+        processCurve(block, ClassicCurve(drive), order, drywet);
+    }
+    else if (algorithm == 1) {
+        processCurve(block, PristineCurve(drive), order, drywet);
+    }
+    else if (algorithm == 2) {
+        processCurve(block, HardCurve(drive), order, drywet);
+    }
+    else if (algorithm == 3) {
+        processCurve(block, MadCurve(drive), order, drywet);
+    }
+}
+
+void AdaaShaper::delayChannel(juce::dsp::AudioBlock<float>& block, size_t channel, Order order) noexcept
+{
+    jassert(channel < block.getNumChannels() && channel < states.size());
+
+    if (channel >= block.getNumChannels() || channel >= states.size())
+        return;
+
+    auto& state = states[channel];
+    auto* channelData = block.getChannelPointer(channel);
+    double x1 = state.x1;
+    double x2 = state.x2;
+
+    //Same arithmetic as the dry signal of processCurve, so a fully dry Mid and Side stay identical
+    for (size_t i = 0; i < block.getNumSamples(); i++) {
+
+        double x = channelData[i];
+        channelData[i] = (float)(order == firstOrder ? 0.5 * (x + x1) : x1);
+
+        x2 = x1;
+        x1 = x;
+    }
+
+    state.x1 = x1;
+    state.x2 = x2;
+}
+
+template <typename Curve>
+void AdaaShaper::processCurve(juce::dsp::AudioBlock<float>& block, const Curve& curve, Order order, float drywet)
+{
+    jassert(block.getNumChannels() <= states.size());
+
+    const double wet = drywet;
+    const double dry = 1.0 - wet;
+    const size_t numChannels = juce::jmin(block.getNumChannels(), states.size());
+
+    for (size_t channel = 0; channel < numChannels; channel++)
+    {
+        auto& state = states[channel];
+        auto* channelData = block.getChannelPointer(channel);
+        double x1 = state.x1;
+        double x2 = state.x2;
+
+        if (order == firstOrder) {
+
+            double F1x1 = curve.F1(x1);
+
+            for (size_t i = 0; i < block.getNumSamples(); i++) {
+
+                double x = channelData[i];
+                double F1x = curve.F1(x);
+                double diff = x - x1;
+
+                double y = std::abs(diff) > firstOrderTolerance ? (F1x - F1x1) / diff
+                                                                : curve.f(0.5 * (x + x1));
+
+                //The wet signal is half a sample late, so is the dry one
+                channelData[i] = (float)(dry * 0.5 * (x + x1) + wet * y);
+
+                x2 = x1;
+                x1 = x;
+                F1x1 = F1x;
+            }
+        }
+        else {
+
+            double F2x1 = curve.F2(x1);
+            double d1 = firstDifference(curve, x1, x2, F2x1, curve.F2(x2));
+
+            for (size_t i = 0; i < block.getNumSamples(); i++) {
+
+                double x = channelData[i];
+                double F2x = curve.F2(x);
+                double d0 = firstDifference(curve, x, x1, F2x, F2x1);
+                double diff = x - x2;
+                double y;
+
+                if (std::abs(diff) > secondOrderTolerance) {
+                    y = 2.0 * (d0 - d1) / diff;
+                }
+                else {
+                    //x and x2 coincide, use the segment around their mean
+                    double xbar = 0.5 * (x + x2);
+                    double delta = xbar - x1;
+
+                    if (std::abs(delta) > secondOrderTolerance)
+                        y = 2.0 / delta * (curve.F1(xbar) + (F2x1 - curve.F2(xbar)) / delta);
+                    else
+                        y = curve.f(0.5 * (xbar + x1));
+                }
+
+                //The wet signal is one sample late, so is the dry one
+                channelData[i] = (float)(dry * x1 + wet * y);
+
+                x2 = x1;
+                x1 = x;
+                F2x1 = F2x;
+                d1 = d0;
+            }
+        }
+
+        state.x1 = x1;
+        state.x2 = x2;
+    }
+}
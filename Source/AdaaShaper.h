@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    AdaaShaper.h
+
+    Antiderivative anti-aliasing (ADAA) versions of the four algorithms.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    First and second order ADAA shapers, a cheap alternative to oversampling.
+
+    Instead of f(x[n]) the shaper outputs the mean of f over the segment between
+    consecutive input samples, computed from the antiderivatives F1 (first
+    order) or F2 (second order). CLASSIC, HARD and MAD use closed form
+    antiderivatives; PRISTINE uses tables built once per process. When two
+    inputs are too close the difference quotient is ill conditioned and the
+    shaper falls back to evaluating the curve at the midpoint.
+
+    ADAA delays the wet signal by half a sample (first order) or one sample
+    (second order), the dry signal is delayed by the same amount before the
+    mix. Every channel keeps its own history.
+*/
+class AdaaShaper
+{
+public:
+    enum Order
+    {
+        firstOrder = 1,
+        secondOrder = 2
+    };
+
+    //Whole samples of delay at the rate the shaper runs, for a QUALITY index: one for the second
+    //order. The half sample of the first order is not a whole number and is not reported
+    static int getLatencyInSamples(int quality) noexcept { return quality == secondOrder ? 1 : 0; }
+
+    //Allocates the history of every channel and builds the PRISTINE tables if needed
+    void prepare(int numChannels);
+    void reset();
+
+    //Gives the destination channel the history of the source, after processing only the source
+    void copyChannelState(int source, int destination) noexcept { states[(size_t)destination] = states[(size_t)source]; }
+
+    //algorithm is the DISTTYPE index: CLASSIC, PRISTINE, HARD, MAD
+    void process(juce::dsp::AudioBlock<float>& block, int algorithm, Order order, float drive, float drywet);
+
+    //The dry path of process() alone on one channel of the block: the delay of the order, with
+    //the history of that channel. M/S keeps Side in line with the shaped Mid this way
+    void delayChannel(juce::dsp::AudioBlock<float>& block, size_t channel, Order order) noexcept;
+
+private:
+    //Previous two inputs of a channel, the antiderivatives are recomputed from
+    //them at every block since DRIVE or the algorithm may have changed
+    struct ChannelState
+    {
+        double x1 = 0.0, x2 = 0.0;
+    };
+
+    template <typename Curve>
+    void processCurve(juce::dsp::AudioBlock<float>& block, const Curve& curve, Order order, float drywet);
+
+    std::vector<ChannelState> states;
+
+    JUCE_LEAK_DETECTOR(AdaaShaper)
+};
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    AutoGain.cpp
+
+    Automatic output gain, matches the loudness of the output to the input.
+
+  ==============================================================================
+*/
+
+#include "AutoGain.h"
+
+//Level the estimators are seeded at, only their ratio matters
+static constexpr double referencePower = 1.0e-3;
+
+void AutoGain::prepare(double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    coefficientSamples = -1;
+
+    gatePower = juce::Decibels::decibelsToGain((double)gateDb) * juce::Decibels::decibelsToGain((double)gateDb);
+
+    makeupGain.reset(sampleRate, rampSeconds);
+    makeupGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(publishedGainDb.load()));
+
+    reset();
+}
+
+void AutoGain::reset() noexcept
+{
+    //Same ratio as the current gain: the estimates move from there, without a jump
+    const double gain = makeupGain.getTargetValue();
+
+    inputPower = referencePower;
+    outputPower = referencePower / (gain * gain);
+
+    blockInputPower = 0.0;
+    output = {};
+    blockSamples = 0;
+}
+
+void AutoGain::setGainDecibels(float gainDb) noexcept
+{
+    gainDb = juce::jlimit(-maximumGainDb, maximumGainDb, gainDb);
+
+    recalledGainDb.store(gainDb);
+    publishedGainDb.store(gainDb);
+    recallPending.store(true);
+}
+
+template <typename SampleType>
+SampleType AutoGain::getSumOfSquares(const SampleType* samples, int numSamples) noexcept
+{
+    //Independent partial sums, one vector register
+    constexpr int numLanes = 8;
+    SampleType sums[numLanes] = {};
+    int i = 0;
+
+    for (; i + numLanes <= numSamples; i += numLanes)
+    {
+        for (int lane = 0; lane < numLanes; lane++)
+            sums[lane] += samples[i + lane] * samples[i + lane];
+    }
+
+    for (; i < numSamples; i++)
+        sums[0] += samples[i] * samples[i];
+
+    SampleType sum = 0;
+
+    for (SampleType partial : sums)
+        sum += partial;
+
+    return sum;
+}
+
+template float AutoGain::getSumOfSquares(const float*, int) noexcept;
+template double AutoGain::getSumOfSquares(const double*, int) noexcept;
+
+template <typename SampleType>
+void AutoGain::beginBlock(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    //A recalled gain replaces the running one, with no ramp
+    if (recallPending.exchange(false)) {
+        makeupGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(recalledGainDb.load()));
+        reset();
+    }
+
+    blockSamples = buffer.getNumSamples();
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    double sum = 0.0;
+
+    for (int channel = 0; channel < numChannels; channel++)
+        sum += getSumOfSquares(buffer.getReadPointer(channel), blockSamples);
+
+    blockInputPower = numChannels > 0 && blockSamples > 0 ? sum / (numChannels * blockSamples) : 0.0;
+    output = {};
+}
+
+template void AutoGain::beginBlock(const juce::AudioBuffer<float>&, int) noexcept;
+template void AutoGain::beginBlock(const juce::AudioBuffer<double>&, int) noexcept;
+
+ParamSmoother::Ramp AutoGain::advance(int numSamples) noexcept
+{
+    ParamSmoother::Ramp ramp;
+    ramp.start = makeupGain.getCurrentValue();
+    ramp.end = makeupGain.skip(numSamples);
+
+    return ramp;
+}
+
+template <typename SampleType>
+void AutoGain::measureOutput(OutputMeasure& measure, const juce::dsp::AudioBlock<SampleType>& block, float gainStart, float gainEnd) noexcept
+{
+    const int numSamples = (int)block.getNumSamples();
+    SampleType sum = 0;
+
+    for (size_t channel = 0; channel < block.getNumChannels(); channel++)
+        sum += getSumOfSquares(block.getChannelPointer(channel), numSamples);
+
+    //Mean square of the ramp, close enough over a sub-block
+    const float gainPower = (gainStart * gainStart + gainEnd * gainEnd) * 0.5f;
+
+    if (gainPower > 0.0f) {
+        measure.sum += sum / gainPower;
+        measure.count += (double)numSamples * (double)block.getNumChannels();
+    }
+}
+
+template void AutoGain::measureOutput(OutputMeasure&, const juce::dsp::AudioBlock<float>&, float, float) noexcept;
+template void AutoGain::measureOutput(OutputMeasure&, const juce::dsp::AudioBlock<double>&, float, float) noexcept;
+
+void AutoGain::addOutput(OutputMeasure& measure) noexcept
+{
+    output.sum += measure.sum;
+    output.count += measure.count;
+    measure = {};
+}
+
+void AutoGain::endBlock() noexcept
+{
+    //Quiet input, or nothing measured: keep the matched level
+    if (blockInputPower < gatePower || output.count <= 0.0)
+        return;
+
+    if (blockSamples != coefficientSamples) {
+        coefficient = 1.0 - std::exp(-blockSamples / (integrationSeconds * currentSampleRate));
+        coefficientSamples = blockSamples;
+    }
+
+    inputPower += (blockInputPower - inputPower) * coefficient;
+    outputPower += (output.sum / output.count - outputPower) * coefficient;
+
+    //A silent chain output (DRIVE muting the signal) would ask for infinite gain
+    const float maximumGain = juce::Decibels::decibelsToGain(maximumGainDb);
+    const float target = outputPower > 0.0 ? (float)std::sqrt(inputPower / outputPower) : maximumGain;
+    const float gain = juce::jlimit(1.0f / maximumGain, maximumGain, target);
+
+    makeupGain.setTargetValue(gain);
+    publishedGainDb.store(juce::Decibels::gainToDecibels(gain));
+}
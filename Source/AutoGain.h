@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    AutoGain.h
+
+    Automatic output gain, matches the loudness of the output to the input.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParamSnapshot.h"
+
+//==============================================================================
+/**
+    Makeup gain that keeps the output of the chain as loud as the input of the
+    plugin, whatever the algorithm and the DRIVE. OUT stays a trim on top.
+
+    Loudness is a running mean square of all channels: every block adds its
+    sum of squares (eight independent accumulators, so the compiler
+    vectorises the loop) to one-pole estimators updated once per block. The
+    output is measured before OUT and the makeup gain, dividing by the gains
+    of each sub-block, so the estimate does not depend on the gain it
+    produces. The square root and the division happen once per block, the
+    makeup itself is smoothed and applied as a ramp per sub-block.
+
+    Blocks with the input below the gate leave the estimates untouched. The
+    gain is saved with the state and the estimators are seeded with it, so a
+    recalled session starts at its matched level with no warm-up.
+*/
+class AutoGain
+{
+public:
+    //Time constant of the loudness estimates
+    static constexpr double integrationSeconds = 3.0;
+
+    //Ramp time of the makeup gain
+    static constexpr double rampSeconds = 0.1;
+
+    //Input level below which the estimates are held, in dBFS
+    static constexpr float gateDb = -70.0f;
+
+    //Range of the makeup gain, in dB
+    static constexpr float maximumGainDb = 24.0f;
+
+    void prepare(double sampleRate);
+
+    //Restarts the estimates from the current gain
+    void reset() noexcept;
+
+    //Gain to start from, applied at the next block. Any thread, for the state
+    void setGainDecibels(float gainDb) noexcept;
+
+    //Last matched gain. Any thread, for the state
+    float getGainDecibels() const noexcept { return publishedGainDb.load(); }
+
+    //Start of a block: loudness of the first numChannels channels of the unprocessed buffer (float or double)
+    template <typename SampleType>
+    void beginBlock(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+    //Makeup gain ramp for the next numSamples samples
+    ParamSmoother::Ramp advance(int numSamples) noexcept;
+
+    //Output sums of one channel group over a block, so the groups measure on their own threads
+    struct OutputMeasure
+    {
+        double sum = 0.0, count = 0.0;
+    };
+
+    //Output of a sub-block, scaled by a gain ramp from gainStart to gainEnd that is divided out
+    template <typename SampleType>
+    static void measureOutput(OutputMeasure& measure, const juce::dsp::AudioBlock<SampleType>& block, float gainStart, float gainEnd) noexcept;
+
+    //Adds the measure of a group to the block and clears it
+    void addOutput(OutputMeasure& measure) noexcept;
+
+    //End of the block: updates the estimates and the makeup target
+    void endBlock() noexcept;
+
+    //Sum of the squares of numSamples samples
+    template <typename SampleType>
+    static SampleType getSumOfSquares(const SampleType* samples, int numSamples) noexcept;
+
+private:
+    //Gain smoothed like the parameters, linear in dB
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> makeupGain;
+
+    //Running mean squares
+    double inputPower = 0.0, outputPower = 0.0;
+
+    //This block: mean square of the input, and the output of every group
+    double blockInputPower = 0.0;
+    OutputMeasure output;
+    int blockSamples = 0;
+
+    //One-pole coefficient for the last block size
+    double coefficient = 0.0;
+    int coefficientSamples = -1;
+
+    double currentSampleRate = 44100.0;
+
+    //gateDb as a power, to compare with the mean square of the input. Set in prepare
+    double gatePower = 0.0;
+
+    std::atomic<float> publishedGainDb { 0.0f };
+    std::atomic<float> recalledGainDb { 0.0f };
+    std::atomic<bool> recallPending { false };
+
+    JUCE_LEAK_DETECTOR(AutoGain)
+};
@@ -0,0 +1,303 @@
+/*
+  ==============================================================================
+
+    CeilingLimiter.cpp
+
+    Lookahead true peak limiter for the CEILING button.
+
+  ==============================================================================
+*/
+
+#include "CeilingLimiter.h"
+
+float CeilingLimiter::getLookaheadSeconds(int index) noexcept
+{
+    //0.5 MS, 1.5 MS, 5 MS
+    static constexpr float seconds[numLookaheads] = { 0.0005f, 0.0015f, 0.005f };
+    return seconds[juce::jlimit(0, numLookaheads - 1, index)];
+}
+
+void CeilingLimiter::prepare(double sampleRate, int numChannels)
+{
+    currentSampleRate = sampleRate;
+
+    //Windowed sinc at 4x, cut at the original Nyquist. Phase p interpolates p / 4 of the way from the
+    //sample interpolatorDelay - 1 frames ago to the one before it, the points of a 4x true peak meter.
+    //Every phase is normalised to unity gain
+    interpolatorGain = 0.0f;
+
+    for (int phase = 0; phase < numPhases; phase++)
+    {
+        const double position = interpolatorDelay - 1 + (double)phase / numPhases;
+        double sum = 0.0;
+
+        for (int tap = 0; tap < tapsPerPhase; tap++)
+        {
+            double t = tap - position;
+            double x = juce::MathConstants<double>::pi * t / (tapsPerPhase / 2);
+            double window = 0.42 + 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+            double sinc = std::abs(t) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+
+            taps[(size_t)tap][(size_t)phase] = (float)(sinc * window);
+            sum += sinc * window;
+        }
+
+        float absoluteSum = 0.0f;
+
+        for (auto& coefficients : taps)
+        {
+            coefficients[(size_t)phase] = (float)(coefficients[(size_t)phase] / sum);
+            absoluteSum += std::abs(coefficients[(size_t)phase]);
+        }
+
+        interpolatorGain = juce::jmax(interpolatorGain, absoluteSum);
+    }
+
+    //Sized for the longest lookahead, nothing is allocated when it changes
+    maxWindowSize = juce::jmax(1, juce::roundToInt(getLookaheadSeconds(numLookaheads - 1) * sampleRate));
+
+    histories.assign((size_t)juce::jmax(1, numChannels), {});
+    channelPointers.assign((size_t)juce::jmax(1, numChannels), nullptr);
+    delayLines.assign((size_t)juce::jmax(1, numChannels), std::vector<float>((size_t)(maxWindowSize + interpolatorDelay), 0.0f));
+
+    minimumValues.assign((size_t)maxWindowSize + 1, 1.0f);
+    minimumFrames.assign((size_t)maxWindowSize + 1, 0);
+    averageValues.assign((size_t)maxWindowSize, 1.0f);
+
+    releaseCoefficient = (float)(1.0 - std::exp(-1.0 / (releaseSeconds * sampleRate)));
+
+    lookaheadIndex = -1;
+    setLookahead(1);
+}
+
+void CeilingLimiter::reset() noexcept
+{
+    for (auto& history : histories)
+        history.fill(0.0f);
+
+    for (auto& delayLine : delayLines)
+        std::fill(delayLine.begin(), delayLine.end(), 0.0f);
+
+    historyIndex = 0;
+    delayIndex = 0;
+
+    minimumHead = 0;
+    minimumSize = 0;
+
+    std::fill(averageValues.begin(), averageValues.end(), 1.0f);
+    averageSum = windowSize;
+    averageIndex = 0;
+
+    envelope = 1.0f;
+    lowestGain = 1.0f;
+    frame = 0;
+    unityFrames = windowSize;
+}
+
+bool CeilingLimiter::setLookahead(int index) noexcept
+{
+    index = juce::jlimit(0, numLookaheads - 1, index);
+
+    if (index == lookaheadIndex)
+        return false;
+
+    lookaheadIndex = index;
+    windowSize = juce::jlimit(1, maxWindowSize, juce::roundToInt(getLookaheadSeconds(index) * currentSampleRate));
+    inverseWindowSize = 1.0 / windowSize;
+    delayLength = getLatencyInSamples();
+
+    reset();
+    return true;
+}
+
+void CeilingLimiter::copyChannelState(int source, int destination) noexcept
+{
+    histories[(size_t)destination] = histories[(size_t)source];
+    std::copy(delayLines[(size_t)source].begin(), delayLines[(size_t)source].begin() + delayLength, delayLines[(size_t)destination].begin());
+}
+
+float CeilingLimiter::getAndResetLowestGain() noexcept
+{
+    float gain = lowestGain;
+    lowestGain = 1.0f;
+    return gain;
+}
+
+template <bool interpolate>
+float CeilingLimiter::getRequiredGain(size_t numChannels) const noexcept
+{
+    float peak = 0.0f;
+
+    for (size_t channel = 0; channel < numChannels; channel++)
+    {
+        const float* window = histories[channel].data() + historyIndex;
+
+        //The two samples around the interpolated points
+        peak = juce::jmax(peak, std::abs(window[interpolatorDelay - 1]), std::abs(window[interpolatorDelay]));
+
+        if (interpolate) {
+
+            float sums[numPhases] = {};
+
+            for (int tap = 0; tap < tapsPerPhase; tap++)
+            {
+                for (int phase = 0; phase < numPhases; phase++)
+                    sums[phase] += taps[(size_t)tap][(size_t)phase] * window[tap];
+            }
+
+            for (int phase = 0; phase < numPhases; phase++)
+                peak = juce::jmax(peak, std::abs(sums[phase]));
+        }
+    }
+
+    return peak > peakLimit ? peakLimit / peak : 1.0f;
+}
+
+float CeilingLimiter::getEnvelope(float requiredGain) noexcept
+{
+    const int capacity = (int)minimumValues.size();
+
+    //Sliding minimum over windowSize + 1 frames. The oldest leaves when it falls out of the window
+    if (minimumSize > 0 && minimumFrames[(size_t)minimumHead] < frame - windowSize) {
+        minimumHead = minimumHead + 1 < capacity ? minimumHead + 1 : 0;
+        minimumSize--;
+    }
+
+    //Larger values before the new one can never be the minimum again
+    while (minimumSize > 0) {
+
+        int back = minimumHead + minimumSize - 1;
+        back -= back >= capacity ? capacity : 0;
+
+        if (minimumValues[(size_t)back] < requiredGain)
+            break;
+
+        minimumSize--;
+    }
+
+    int back = minimumHead + minimumSize;
+    back -= back >= capacity ? capacity : 0;
+    minimumValues[(size_t)back] = requiredGain;
+    minimumFrames[(size_t)back] = frame;
+    minimumSize++;
+
+    const float held = minimumValues[(size_t)minimumHead];
+    unityFrames = held < 1.0f ? 0 : unityFrames + 1;
+
+    //Moving average: a held dip is reached windowSize - 1 frames after it was measured
+    averageSum += held - averageValues[(size_t)averageIndex];
+    averageValues[(size_t)averageIndex] = held;
+    averageIndex = averageIndex + 1 < windowSize ? averageIndex + 1 : 0;
+
+    const float target = juce::jmin(1.0f, (float)(averageSum * inverseWindowSize));
+
+    //Attack follows the average, release recovers slowly
+    envelope = target < envelope ? target : envelope + (target - envelope) * releaseCoefficient;
+    frame++;
+
+    return envelope;
+}
+
+void CeilingLimiter::process(juce::dsp::AudioBlock<float>& block, float gainStart, float gainEnd) noexcept
+{
+    const size_t numChannels = juce::jmin(block.getNumChannels(), histories.size());
+    const int numSamples = (int)block.getNumSamples();
+    const float gainIncrement = numSamples > 0 ? (gainEnd - gainStart) / (float)numSamples : 0.0f;
+
+    //The interpolated peaks cannot reach the ceiling if the inputs in the interpolator stay below ceiling / interpolatorGain
+    float inputPeak = 0.0f;
+
+    for (size_t channel = 0; channel < numChannels; channel++)
+    {
+        channelPointers[channel] = block.getChannelPointer(channel);
+
+        auto range = juce::FloatVectorOperations::findMinAndMax(channelPointers[channel], numSamples);
+        auto historyRange = juce::FloatVectorOperations::findMinAndMax(histories[channel].data() + historyIndex, tapsPerPhase);
+
+        inputPeak = juce::jmax(inputPeak, std::abs(range.getStart()), std::abs(range.getEnd()));
+        inputPeak = juce::jmax(inputPeak, std::abs(historyRange.getStart()), std::abs(historyRange.getEnd()));
+    }
+
+    //Inter-sample peaks can go above the sample peak: the bound of the interpolated values decides
+    const bool interpolate = inputPeak * interpolatorGain > peakLimit;
+
+    //Nothing to limit, not even between the samples, and the envelope has recovered: only the delay and the output gain
+    if (!interpolate && unityFrames >= windowSize && envelope >= 0.99999f) {
+        processUnity(numChannels, numSamples, gainStart, gainIncrement);
+        return;
+    }
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        //Newest sample first in the window
+        historyIndex = historyIndex > 0 ? historyIndex - 1 : tapsPerPhase - 1;
+
+        for (size_t channel = 0; channel < numChannels; channel++)
+        {
+            float sample = channelPointers[channel][i];
+            histories[channel][(size_t)historyIndex] = sample;
+            histories[channel][(size_t)(historyIndex + tapsPerPhase)] = sample;
+        }
+
+        float requiredGain = interpolate ? getRequiredGain<true>(numChannels) : getRequiredGain<false>(numChannels);
+        float limiterGain = getEnvelope(requiredGain);
+        float gain = limiterGain * (gainStart + gainIncrement * (float)i);
+        lowestGain = juce::jmin(lowestGain, limiterGain);
+
+        for (size_t channel = 0; channel < numChannels; channel++)
+        {
+            float& delayed = delayLines[channel][(size_t)delayIndex];
+
+            float input = channelPointers[channel][i];
+            channelPointers[channel][i] = delayed * gain;
+            delayed = input;
+        }
+
+        delayIndex = delayIndex + 1 < delayLength ? delayIndex + 1 : 0;
+    }
+}
+
+void CeilingLimiter::processUnity(size_t numChannels, int numSamples, float gainStart, float gainIncrement) noexcept
+{
+    const int firstHistorySample = juce::jmax(0, numSamples - tapsPerPhase);
+    int newHistoryIndex = historyIndex;
+
+    for (size_t channel = 0; channel < numChannels; channel++)
+    {
+        float* samples = channelPointers[channel];
+        auto& history = histories[channel];
+
+        //The interpolator keeps the last inputs for the next blocks
+        newHistoryIndex = historyIndex;
+
+        for (int i = firstHistorySample; i < numSamples; i++)
+        {
+            newHistoryIndex = newHistoryIndex > 0 ? newHistoryIndex - 1 : tapsPerPhase - 1;
+            history[(size_t)newHistoryIndex] = samples[i];
+            history[(size_t)(newHistoryIndex + tapsPerPhase)] = samples[i];
+        }
+
+        float* delayLine = delayLines[channel].data();
+        int index = delayIndex;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            float input = samples[i];
+            samples[i] = delayLine[index] * (gainStart + gainIncrement * (float)i);
+            delayLine[index] = input;
+            index = index + 1 < delayLength ? index + 1 : 0;
+        }
+    }
+
+    historyIndex = newHistoryIndex;
+    delayIndex = (delayIndex + numSamples) % delayLength;
+
+    //Same state as numSamples frames of unity gain
+    frame += numSamples;
+    minimumHead = 0;
+    minimumSize = 1;
+    minimumValues[0] = 1.0f;
+    minimumFrames[0] = frame - 1;
+    averageSum = windowSize;
+    envelope = 1.0f;
+}
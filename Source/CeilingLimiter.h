@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    CeilingLimiter.h
+
+    Lookahead true peak limiter for the CEILING button.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Keeps the true peak of the output below the ceiling, then applies the
+    output gain ramp, so the output peaks at the level of the OUT knob.
+
+    The peak of every frame is measured at 4x with a polyphase interpolator,
+    the largest of all channels drives one gain shared by the channels. The
+    gain each frame needs is held over the lookahead window with a sliding
+    minimum (monotonic deque) and smoothed with a moving average of the same
+    length, so the gain reaches the needed value exactly when the delayed
+    peak comes out and the attack is a linear ramp. Releases are a one-pole
+    recovery. Everything is O(1) per frame whatever the lookahead, the
+    interpolator is skipped for sub-blocks whose peaks cannot reach the
+    ceiling, and once the gain is back at unity quiet sub-blocks are only
+    delayed.
+
+    The audio is delayed by getLatencyInSamples(). Every buffer is sized for
+    the longest lookahead in prepare().
+*/
+class CeilingLimiter
+{
+public:
+    //LOOKAHEAD choices
+    static constexpr int numLookaheads = 3;
+
+    //Largest true peak at the output of the limiter, before the output gain
+    static constexpr float ceiling = 1.0f;
+
+    //Level the interpolated peaks are limited to: 0.05 dB below the ceiling, more than the
+    //interpolator underestimates any peak below 0.3 of the samplerate
+    static constexpr float peakLimit = ceiling * 0.99426f;
+
+    static constexpr double releaseSeconds = 0.05;
+
+    void prepare(double sampleRate, int numChannels);
+    void reset() noexcept;
+
+    //Selects the lookahead (LOOKAHEAD index), returns true if it changed and with it the latency.
+    //The limiter restarts from silence
+    bool setLookahead(int index) noexcept;
+
+    int getLatencyInSamples() const noexcept { return windowSize - 1 + interpolatorDelay; }
+
+    //Limits the block in place and applies a linear gain ramp after the limiter
+    void process(juce::dsp::AudioBlock<float>& block, float gainStart, float gainEnd) noexcept;
+
+    //Gives the destination channel the history of the source, after processing only the source
+    void copyChannelState(int source, int destination) noexcept;
+
+    //Lowest gain applied since the last call, for the meters
+    float getAndResetLowestGain() noexcept;
+
+private:
+    static float getLookaheadSeconds(int index) noexcept;
+
+    //4x interpolator, 12 taps per phase. The phases fall at 0, 1/4, 1/2 and 3/4 of the
+    //way from the input sample interpolatorDelay - 1 frames ago to the older one
+    static constexpr int numPhases = 4;
+    static constexpr int tapsPerPhase = 12;
+    static constexpr int interpolatorDelay = tapsPerPhase / 2;
+
+    //Gain needed by the current frame, from the interpolated peaks
+    template <bool interpolate>
+    float getRequiredGain(size_t numChannels) const noexcept;
+
+    //Sliding minimum, moving average and release of the required gain
+    float getEnvelope(float requiredGain) noexcept;
+
+    //Fast path while the gain stays at unity: delay and output gain only
+    void processUnity(size_t numChannels, int numSamples, float gainStart, float gainIncrement) noexcept;
+
+    //Coefficients by tap, the four phases next to each other so they are computed as one vector
+    std::array<std::array<float, numPhases>, tapsPerPhase> taps{};
+
+    //Largest sum of absolute coefficients of a phase: no interpolated value is
+    //larger than this times the largest input
+    float interpolatorGain = 1.0f;
+
+    //Last tapsPerPhase inputs of every channel, stored twice so the window
+    //starting at historyIndex is contiguous
+    std::vector<std::array<float, 2 * tapsPerPhase>> histories;
+    int historyIndex = 0;
+
+    //Channels of the block being processed, sized in prepare
+    std::vector<float*> channelPointers;
+
+    //Delayed audio, one ring of maxDelay samples per channel
+    std::vector<std::vector<float>> delayLines;
+    int delayIndex = 0, delayLength = 0;
+
+    //Monotonic deque of (gain, frame) over the last windowSize + 1 frames
+    std::vector<float> minimumValues;
+    std::vector<juce::int64> minimumFrames;
+    int minimumHead = 0, minimumSize = 0;
+
+    //Moving average of the held minimum over windowSize frames
+    std::vector<float> averageValues;
+    double averageSum = 0.0, inverseWindowSize = 1.0;
+    int averageIndex = 0;
+
+    float envelope = 1.0f, lowestGain = 1.0f;
+    float releaseCoefficient = 0.0f;
+
+    //Consecutive frames whose held gain was 1, all the averaged values are 1 after windowSize of them
+    int unityFrames = 0;
+
+    juce::int64 frame = 0;
+    int windowSize = 1, maxWindowSize = 1, lookaheadIndex = 1;
+    double currentSampleRate = 44100.0;
+
+    JUCE_LEAK_DETECTOR(CeilingLimiter)
+};
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    ChannelGroup.cpp
+
+    Pairs and single channels of the bus, each with its own DSP state.
+
+  ==============================================================================
+*/
+
+#include "ChannelGroup.h"
+
+//Left and right channel types that make a pair
+static const std::pair<juce::AudioChannelSet::ChannelType, juce::AudioChannelSet::ChannelType> layoutPairs[] = {
+    { juce::AudioChannelSet::left, juce::AudioChannelSet::right },
+    { juce::AudioChannelSet::leftCentre, juce::AudioChannelSet::rightCentre },
+    { juce::AudioChannelSet::leftSurround, juce::AudioChannelSet::rightSurround },
+    { juce::AudioChannelSet::leftSurroundSide, juce::AudioChannelSet::rightSurroundSide },
+    { juce::AudioChannelSet::leftSurroundRear, juce::AudioChannelSet::rightSurroundRear },
+    { juce::AudioChannelSet::wideLeft, juce::AudioChannelSet::wideRight },
+    { juce::AudioChannelSet::topFrontLeft, juce::AudioChannelSet::topFrontRight },
+    { juce::AudioChannelSet::topRearLeft, juce::AudioChannelSet::topRearRight },
+};
+
+std::vector<ChannelGroup::Channels> ChannelGroup::getLayoutGroups(const juce::AudioChannelSet& layout)
+{
+    const int numChannels = layout.size();
+    std::vector<Channels> groups;
+
+    //No names to match: 1-2, 3-4...
+    if (layout.isDiscreteLayout()) {
+
+        for (int channel = 0; channel < numChannels; channel += 2)
+            groups.push_back({ channel, channel + 1 < numChannels ? channel + 1 : -1 });
+
+        return groups;
+    }
+
+    std::vector<bool> grouped((size_t)numChannels, false);
+
+    for (int channel = 0; channel < numChannels; channel++) {
+
+        if (grouped[(size_t)channel])
+            continue;
+
+        const auto type = layout.getTypeOfChannel(channel);
+        Channels group { channel, -1 };
+
+        for (const auto& pair : layoutPairs) {
+
+            if (type != pair.first && type != pair.second)
+                continue;
+
+            const int left = layout.getChannelIndexForType(pair.first);
+            const int right = layout.getChannelIndexForType(pair.second);
+
+            if (left >= 0 && right >= 0)
+                group = { left, right };
+
+            break;
+        }
+
+        for (int member : group)
+            if (member >= 0)
+                grouped[(size_t)member] = true;
+
+        groups.push_back(group);
+    }
+
+    return groups;
+}
+
+ChannelGroup::ChannelGroup(Channels busChannels) noexcept
+    : channels(busChannels)
+{
+}
+
+void ChannelGroup::prepare(double sampleRate, int maximumBlockSize)
+{
+    const int numChannels = getNumChannels();
+
+    //PRE and POST Filters, in both precisions, the processor sets their coefficients
+    preTone.prepare(numChannels);
+    postTone.prepare(numChannels);
+    preToneDouble.prepare(numChannels);
+    postToneDouble.prepare(numChannels);
+
+    //Double sub-blocks through the float stages
+    doubleScratch.setSize(numChannels, ParamSmoother::subBlockSize);
+
+    //Oversampling around the distortion, every factor is allocated here
+    oversampling.prepare(numChannels, maximumBlockSize);
+
+    //Ceiling limiter, buffers sized for the longest lookahead
+    ceilingLimiter.prepare(sampleRate, numChannels);
+
+    //History of the antiderivative shapers
+    adaa.prepare(numChannels);
+
+    //Multiband, the bands of the longest oversampled sub-block
+    multiband.prepare(numChannels, ParamSmoother::subBlockSize << (OversamplingStage::numFactors - 1));
+    multiband.reset();
+
+    for (auto& shaper : bandAdaa)
+        shaper.prepare(numChannels);
+
+    autoGainOutput = {};
+}
+
+void ChannelGroup::reset()
+{
+    preTone.reset();
+    postTone.reset();
+    preToneDouble.reset();
+    postToneDouble.reset();
+    oversampling.reset();
+    adaa.reset();
+    multiband.reset();
+    ceilingLimiter.reset();
+
+    for (auto& shaper : bandAdaa)
+        shaper.reset();
+}
+
+void ChannelGroup::copyChannelState() noexcept
+{
+    preTone.copyChannelState(0, 1);
+    postTone.copyChannelState(0, 1);
+    preToneDouble.copyChannelState(0, 1);
+    postToneDouble.copyChannelState(0, 1);
+    adaa.copyChannelState(0, 1);
+    multiband.copyChannelState(0, 1);
+    ceilingLimiter.copyChannelState(0, 1);
+
+    for (auto& shaper : bandAdaa)
+        shaper.copyChannelState(0, 1);
+}
+
+void ChannelGroup::setFilterCoefficients(const ToneCoefficientManager::Coefficients& coefficients) noexcept
+{
+    using Section = ToneCoefficientManager::Section;
+
+    //Processing order of the sections
+    static constexpr Section preOrder[] = { Section::lowPass, Section::highPass, Section::highShelf, Section::lowShelf, Section::midBell };
+    static constexpr Section postOrder[] = { Section::highShelf, Section::lowShelf, Section::midBell, Section::lowPass, Section::highPass };
+
+    //Both precisions, only one of them runs
+    for (int position = 0; position < ToneCoefficientManager::numSections; position++)
+    {
+        preTone.setCoefficients(position, coefficients.pre[(size_t)preOrder[position]]);
+        preToneDouble.setCoefficients(position, coefficients.pre[(size_t)preOrder[position]]);
+        postTone.setCoefficients(position, coefficients.post[(size_t)postOrder[position]]);
+        postToneDouble.setCoefficients(position, coefficients.post[(size_t)postOrder[position]]);
+    }
+}
@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    ChannelGroup.h
+
+    Pairs and single channels of the bus, each with its own DSP state.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ToneFilters.h"
+#include "ToneStage.h"
+#include "OversamplingStage.h"
+#include "AdaaShaper.h"
+#include "MultibandSplitter.h"
+#include "CeilingLimiter.h"
+#include "AutoGain.h"
+
+//==============================================================================
+/**
+    One or two channels of the bus that go through the chain together, with
+    every filter, oversampler, shaper history and limiter they need.
+
+    getLayoutGroups() splits a layout: the left/right pairs of the layout
+    (front, surround, rear, wide, top) become pairs that MIDSIDE encodes,
+    discrete layouts are paired in order, and every other channel (centre,
+    LFE, ambisonic components) is a group of its own. A stereo bus is a
+    single pair, the chain of the stereo plugin.
+
+    Groups share no state, so the groups of a block can run on different
+    threads. A pair keeps one ceiling gain for both channels; separate groups
+    are limited separately.
+*/
+class ChannelGroup
+{
+public:
+    //Largest bus: 9.1.6 and 3rd order ambisonics
+    static constexpr int maxChannels = 16;
+
+    //Channels of the bus in a group, the left one first. The second is -1 for a single channel
+    using Channels = std::array<int, 2>;
+
+    //Groups of a layout, in the order of their first channel
+    static std::vector<Channels> getLayoutGroups(const juce::AudioChannelSet& layout);
+
+    explicit ChannelGroup(Channels busChannels) noexcept;
+
+    //Allocates every stage for the channels of the group
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    //Every history back to silence
+    void reset();
+
+    int getNumChannels() const noexcept { return channels[1] < 0 ? 1 : 2; }
+    int getChannel(int index) const noexcept { return channels[(size_t)index]; }
+
+    //Left/right pair, which MIDSIDE encodes
+    bool isPair() const noexcept { return channels[1] >= 0; }
+
+    //Channels of the group in the buffer, the first numChannels of them, startSample onwards
+    template <typename SampleType>
+    juce::dsp::AudioBlock<SampleType> getBlock(juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples) noexcept;
+
+    //Gives the second channel the histories of the first, after processing only the first
+    void copyChannelState() noexcept;
+
+    //Copies the designed coefficients into the PRE and POST cascades of both precisions
+    void setFilterCoefficients(const ToneCoefficientManager::Coefficients&) noexcept;
+
+    //PRE and POST cascades of the sample type
+    template <typename SampleType>
+    ToneStage<SampleType>& getPreTone() noexcept;
+
+    template <typename SampleType>
+    ToneStage<SampleType>& getPostTone() noexcept;
+
+    //IIR filters, the five PRE and the five POST biquads each fused in one pass,
+    //for float and for double processing
+    ToneStage<float> preTone, postTone;
+    ToneStage<double> preToneDouble, postToneDouble;
+
+    //Oversampling around the distortion
+    OversamplingStage oversampling;
+
+    //Antiderivative anti-aliased shapers, QUALITY ADAA1 / ADAA2
+    AdaaShaper adaa;
+
+    //Multiband mode: crossovers around the oversampled shapers, one ADAA history per band
+    MultibandSplitter multiband;
+    std::array<AdaaShaper, MultibandSplitter::maxBands> bandAdaa;
+
+    //True peak lookahead limiter, CEILING button
+    CeilingLimiter ceilingLimiter;
+
+    //AUTOGAIN measure of the output of this block
+    AutoGain::OutputMeasure autoGainOutput;
+
+    //Double sub-blocks converted for the float stages, subBlockSize samples
+    juce::AudioBuffer<float> doubleScratch;
+
+private:
+    template <typename SampleType>
+    std::array<SampleType*, 2>& getChannelPointers() noexcept;
+
+    Channels channels;
+
+    //Channel pointers of the last getBlock
+    std::array<float*, 2> floatPointers {};
+    std::array<double*, 2> doublePointers {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelGroup)
+};
+
+template <>
+inline std::array<float*, 2>& ChannelGroup::getChannelPointers<float>() noexcept { return floatPointers; }
+
+template <>
+inline std::array<double*, 2>& ChannelGroup::getChannelPointers<double>() noexcept { return doublePointers; }
+
+template <>
+inline ToneStage<float>& ChannelGroup::getPreTone<float>() noexcept { return preTone; }
+
+template <>
+inline ToneStage<double>& ChannelGroup::getPreTone<double>() noexcept { return preToneDouble; }
+
+template <>
+inline ToneStage<float>& ChannelGroup::getPostTone<float>() noexcept { return postTone; }
+
+template <>
+inline ToneStage<double>& ChannelGroup::getPostTone<double>() noexcept { return postToneDouble; }
+
+template <typename SampleType>
+juce::dsp::AudioBlock<SampleType> ChannelGroup::getBlock(juce::AudioBuffer<SampleType>& buffer, int numChannels, int startSample, int numSamples) noexcept
+{
+    auto& pointers = getChannelPointers<SampleType>();
+
+    for (int index = 0; index < numChannels; index++)
+        pointers[(size_t)index] = buffer.getWritePointer(channels[(size_t)index]);
+
+    return { pointers.data(), (size_t)numChannels, (size_t)startSample, (size_t)numSamples };
+}
@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    MultibandSplitter.cpp
+
+    Linkwitz-Riley crossovers for the multiband distortion.
+
+  ==============================================================================
+*/
+
+#include "MultibandSplitter.h"
+
+//Butterworth damping, 1 / Q
+static constexpr float damping = juce::MathConstants<float>::sqrt2;
+
+void MultibandSplitter::prepare(int numChannels, int maximumBlockSize)
+{
+    states.assign((size_t)juce::jmax(1, numChannels), ChannelState());
+
+    for (auto& buffer : bandBuffers)
+        buffer.setSize(juce::jmax(1, numChannels), juce::jmax(1, maximumBlockSize));
+
+    lastNumChannels = 0;
+    lastNumSamples = 0;
+}
+
+void MultibandSplitter::reset() noexcept
+{
+    std::fill(states.begin(), states.end(), ChannelState());
+}
+
+bool MultibandSplitter::setCrossovers(double sampleRate, const std::array<float, maxCrossovers>& frequencies, int bands) noexcept
+{
+    bands = juce::jlimit(1, maxBands, bands);
+
+    if (bands == numBands && juce::approximatelyEqual(sampleRate, currentSampleRate) && frequencies == currentFrequencies)
+        return false;
+
+    if (bands != numBands)
+        reset();
+
+    numBands = bands;
+    currentSampleRate = sampleRate;
+    currentFrequencies = frequencies;
+
+    for (size_t crossover = 0; crossover < (size_t)maxCrossovers; crossover++)
+    {
+        //Prewarped, kept below Nyquist
+        const double frequency = juce::jlimit(10.0, sampleRate * 0.49, (double)frequencies[crossover]);
+        const double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const double a1 = 1.0 / (1.0 + g * (g + damping));
+
+        coefficients[crossover].a1 = (float)a1;
+        coefficients[crossover].a2 = (float)(g * a1);
+        coefficients[crossover].a3 = (float)(g * g * a1);
+    }
+
+    return true;
+}
+
+int MultibandSplitter::getTailSamples(double sampleRate) const noexcept
+{
+    if (numBands < 2)
+        return 0;
+
+    //The Butterworth poles decay by 120 dB in 13.8 / (pi sqrt 2 f) seconds, half as much
+    //again for the double poles and the allpasses in cascade: about 4.7 periods of the lowest crossover
+    const double lowest = juce::jmax(10.0f, currentFrequencies[0]);
+    return (int)std::ceil(4.7 / lowest * sampleRate);
+}
+
+void MultibandSplitter::split(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    jassert(block.getNumChannels() <= states.size() && (int)block.getNumSamples() <= bandBuffers[0].getNumSamples());
+
+    lastNumChannels = juce::jmin(block.getNumChannels(), states.size());
+    lastNumSamples = juce::jmin(block.getNumSamples(), (size_t)bandBuffers[0].getNumSamples());
+
+    size_t channel = 0;
+
+    //The frame loop is specialised for the number of crossovers, so it is fully unrolled
+    using SplitFrames = void (MultibandSplitter::*)(const juce::dsp::AudioBlock<float>&, size_t) noexcept;
+
+    static constexpr SplitFrames pairs[] = { &MultibandSplitter::splitFrames<2, 1>, &MultibandSplitter::splitFrames<2, 2>, &MultibandSplitter::splitFrames<2, 3> };
+    static constexpr SplitFrames singles[] = { &MultibandSplitter::splitFrames<1, 1>, &MultibandSplitter::splitFrames<1, 2>, &MultibandSplitter::splitFrames<1, 3> };
+
+    if (numBands < 2)
+        return;
+
+    //Pairs of channels share the frame loop, their filters run side by side
+    for (; channel + 1 < lastNumChannels; channel += 2)
+        (this->*pairs[numBands - 2])(block, channel);
+
+    if (channel < lastNumChannels)
+        (this->*singles[numBands - 2])(block, channel);
+}
+
+//Tick of a TPT SVF, returns the band pass output and gives the low pass in lowPass
+static inline float tick(const MultibandSplitter::Coefficients& k, MultibandSplitter::Svf& svf, float v0, float& lowPass) noexcept
+{
+    float v3 = v0 - svf.ic2;
+    float v1 = k.a1 * svf.ic1 + k.a2 * v3;
+    float v2 = svf.ic2 + k.a2 * svf.ic1 + k.a3 * v3;
+    svf.ic1 = 2.0f * v1 - svf.ic1;
+    svf.ic2 = 2.0f * v2 - svf.ic2;
+
+    lowPass = v2;
+    return v1;
+}
+
+//LR4 pair from three SVFs: the first gives both 2nd order slopes, the other two complete them
+static inline void crossover(const MultibandSplitter::Coefficients& k, MultibandSplitter::Svf* svfs, float x, float& low, float& high) noexcept
+{
+    float lp;
+    float bp = tick(k, svfs[0], x, lp);
+    float hp = x - damping * bp - lp;
+
+    tick(k, svfs[1], lp, low);
+
+    float highLp;
+    float highBp = tick(k, svfs[2], hp, highLp);
+    high = hp - damping * highBp - highLp;
+}
+
+//2nd order allpass with the poles of the crossover, the phase of its LR4 sum
+static inline float allpass(const MultibandSplitter::Coefficients& k, MultibandSplitter::Svf& svf, float x) noexcept
+{
+    float lp;
+    return x - 2.0f * damping * tick(k, svf, x, lp);
+}
+
+template <int numChannels, int numCrossovers>
+void MultibandSplitter::splitFrames(const juce::dsp::AudioBlock<float>& block, size_t firstChannel) noexcept
+{
+    constexpr int numBandsSplit = numCrossovers + 1;
+
+    //Local copies, so the compiler can keep everything in registers
+    const auto c = coefficients;
+    ChannelState s[(size_t)numChannels];
+
+    const float* inputs[(size_t)numChannels];
+    float* bands[(size_t)numChannels][(size_t)maxBands] = {};
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        s[ch] = states[firstChannel + (size_t)ch];
+        inputs[ch] = block.getChannelPointer(firstChannel + (size_t)ch);
+
+        for (int band = 0; band < numBandsSplit; band++)
+            bands[ch][band] = bandBuffers[(size_t)band].getWritePointer((int)firstChannel + ch);
+    }
+
+    for (size_t i = 0; i < lastNumSamples; i++)
+    {
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            Svf* f = s[ch].data();
+            float* const* out = bands[ch];
+            const float x = inputs[ch][i];
+
+            if (numCrossovers == 1) {
+                crossover(c[0], f, x, out[0][i], out[1][i]);
+            }
+            else if (numCrossovers == 2) {
+                //Low band through the allpass of the upper crossover
+                float low, high;
+                crossover(c[0], f, x, low, high);
+                out[0][i] = allpass(c[1], f[3], low);
+                crossover(c[1], f + 4, high, out[1][i], out[2][i]);
+            }
+            else {
+                //Balanced tree, middle crossover first: each half goes through the allpass
+                //of the crossover of the other half, one allpass per band added
+                float low, high;
+                crossover(c[1], f, x, low, high);
+                crossover(c[0], f + 3, allpass(c[2], f[6], low), out[0][i], out[1][i]);
+                crossover(c[2], f + 7, allpass(c[0], f[10], high), out[2][i], out[3][i]);
+            }
+        }
+    }
+
+    //Denormals are flushed at the end of the block, like the tone filters
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        for (auto& svf : s[ch])
+        {
+            juce::dsp::util::snapToZero(svf.ic1);
+            juce::dsp::util::snapToZero(svf.ic2);
+        }
+
+        states[firstChannel + (size_t)ch] = s[ch];
+    }
+}
+
+juce::dsp::AudioBlock<float> MultibandSplitter::getBand(int band) noexcept
+{
+    return juce::dsp::AudioBlock<float>(bandBuffers[(size_t)band]).getSubsetChannelBlock(0, lastNumChannels).getSubBlock(0, lastNumSamples);
+}
+
+void MultibandSplitter::sum(juce::dsp::AudioBlock<float>& block) noexcept
+{
+    for (size_t channel = 0; channel < lastNumChannels; channel++)
+    {
+        float* output = block.getChannelPointer(channel);
+        juce::FloatVectorOperations::copy(output, bandBuffers[0].getReadPointer((int)channel), (int)lastNumSamples);
+
+        for (int band = 1; band < numBands; band++)
+            juce::FloatVectorOperations::add(output, bandBuffers[(size_t)band].getReadPointer((int)channel), (int)lastNumSamples);
+    }
+}
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    MultibandSplitter.h
+
+    Linkwitz-Riley crossovers for the multiband distortion.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Splits a block in 2 to 4 bands that sum back flat.
+
+    Every crossover is a 4th order Linkwitz-Riley pair built from Butterworth
+    state variable filters (TPT, stable under modulation): one SVF gives the
+    first low and high pass stages together, a second one per output
+    completes each slope. LP + HP of an LR4 pair is a 2nd order allpass, so a
+    band that does not go through a crossover goes through its allpass
+    instead and the bands sum to an allpass with a flat magnitude. Four bands
+    are split as a balanced tree (middle crossover first), which needs one
+    allpass per band after the second, so the cost grows linearly with the
+    bands: 3, 7 and 11 SVFs for 2, 3 and 4 bands.
+
+    split() computes every band of a frame in one pass over the block, with
+    the two channels of a pair side by side and the loop specialised for the
+    number of crossovers. The bands live in buffers sized in prepare() and
+    are summed back in place by sum(). Every channel keeps its own states.
+*/
+class MultibandSplitter
+{
+public:
+    static constexpr int maxBands = 4;
+    static constexpr int maxCrossovers = maxBands - 1;
+
+    //Allocates the band buffers, maximumBlockSize is the largest block split (oversampled)
+    void prepare(int numChannels, int maximumBlockSize);
+    void reset() noexcept;
+
+    //Bands and crossover frequencies (ascending, Hz) for a signal at sampleRate. Returns true
+    //if anything changed; the states restart from silence when the number of bands does
+    bool setCrossovers(double sampleRate, const std::array<float, maxCrossovers>& frequencies, int numBands) noexcept;
+
+    int getNumBands() const noexcept { return numBands; }
+
+    //Samples for the impulse response of the bands to decay below -120 dB, at the given samplerate
+    int getTailSamples(double sampleRate) const noexcept;
+
+    //Splits the block into getNumBands() bands, readable with getBand until the next split
+    void split(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    //Band of the last split, same channels and samples as the block
+    juce::dsp::AudioBlock<float> getBand(int band) noexcept;
+
+    //Replaces the block with the sum of the bands
+    void sum(juce::dsp::AudioBlock<float>& block) noexcept;
+
+    //Gives the destination channel the filter states of the source, after processing only the source
+    void copyChannelState(int source, int destination) noexcept { states[(size_t)destination] = states[(size_t)source]; }
+
+    //Butterworth SVF coefficients (k = sqrt 2) at one crossover
+    struct Coefficients
+    {
+        float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f;
+    };
+
+    //TPT SVF integrator states
+    struct Svf
+    {
+        float ic1 = 0.0f, ic2 = 0.0f;
+    };
+
+private:
+    //Three SVFs per crossover and one allpass per band after the second
+    static constexpr int maxFilters = 3 * maxCrossovers + maxBands - 2;
+
+    using ChannelState = std::array<Svf, maxFilters>;
+
+    //Frame loop of split() for one channel or a pair
+    template <int numChannels, int numCrossovers>
+    void splitFrames(const juce::dsp::AudioBlock<float>& block, size_t firstChannel) noexcept;
+
+    std::array<Coefficients, maxCrossovers> coefficients;
+    std::array<float, maxCrossovers> currentFrequencies {};
+
+    std::vector<ChannelState> states;
+    std::array<juce::AudioBuffer<float>, maxBands> bandBuffers;
+
+    int numBands = 1;
+    size_t lastNumChannels = 0, lastNumSamples = 0;
+    double currentSampleRate = 0.0;
+
+    JUCE_LEAK_DETECTOR(MultibandSplitter)
+};
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    OversamplingStage.cpp
+
+    Selectable oversampling wrapped around the non linear section.
+
+  ==============================================================================
+*/
+
+#include "OversamplingStage.h"
+
+void OversamplingStage::prepare(int numChannels, int maximumBlockSize)
+{
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+
+    for (int factor = 1; factor < numFactors; factor++)
+    {
+        //IIR: cheaper filters, lowest latency. FIR: linear phase, max quality
+        oversamplers[(size_t)factor][polyphaseIIR] = std::make_unique<juce::dsp::Oversampling<float>>(
+            (size_t)numChannels, (size_t)factor, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false, true);
+
+        oversamplers[(size_t)factor][linearPhaseFIR] = std::make_unique<juce::dsp::Oversampling<float>>(
+            (size_t)numChannels, (size_t)factor, juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true, true);
+
+        //Render: narrower transition bands and 20 dB more stopband attenuation than FIR,
+        //same stage layout as the JUCE max quality design. Latency and cost are much higher
+        auto render = std::make_unique<juce::dsp::Oversampling<float>>((size_t)numChannels);
+
+        for (int stage = 0; stage < factor; stage++)
+        {
+            render->addOversamplingStage(juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple,
+                                         stage == 0 ? 0.03f : 0.08f, -110.0f + 10.0f * (float)stage,
+                                         stage == 0 ? 0.04f : 0.10f, -95.0f + 10.0f * (float)stage);
+        }
+
+        render->setUsingIntegerLatency(true);
+        oversamplers[(size_t)factor][renderFIR] = std::move(render);
+
+        for (auto& oversampler : oversamplers[(size_t)factor])
+            oversampler->initProcessing((size_t)maxBlockSize);
+    }
+
+    reset();
+}
+
+void OversamplingStage::reset()
+{
+    if (auto* oversampler = getActive())
+        oversampler->reset();
+}
+
+bool OversamplingStage::setMode(int factorIndex, FilterMode mode)
+{
+    factorIndex = juce::jlimit(0, numFactors - 1, factorIndex);
+
+    if (factorIndex == currentFactor && mode == currentMode)
+        return false;
+
+    currentFactor = factorIndex;
+    currentMode = mode;
+
+    //Start the new filters from silence
+    reset();
+    return true;
+}
+
+int OversamplingStage::getLatencyInSamples() const noexcept
+{
+    if (auto* oversampler = getActive())
+        return juce::roundToInt(oversampler->getLatencyInSamples());
+
+    return 0;
+}
+
+juce::dsp::Oversampling<float>* OversamplingStage::getActive() const noexcept
+{
+    if (currentFactor == 0)
+        return nullptr;
+
+    return oversamplers[(size_t)currentFactor][currentMode].get();
+}
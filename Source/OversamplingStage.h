@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    OversamplingStage.h
+
+    Selectable oversampling wrapped around the non linear section.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Runs the distortion at 1x, 2x, 4x or 8x the host samplerate.
+
+    Every factor/filter combination is built in prepare(), so switching the
+    setting while playing only resets the selected oversampler and never
+    allocates. The polyphase IIR mode has the lowest latency, for tracking;
+    the FIR mode is linear phase with steeper filters, for mixdown. The render
+    FIR mode has longer filters still and is only used for offline bounces.
+*/
+class OversamplingStage
+{
+public:
+    //1x, 2x, 4x, 8x
+    static constexpr int numFactors = 4;
+
+    enum FilterMode
+    {
+        polyphaseIIR = 0,
+        linearPhaseFIR,
+        renderFIR,
+        numFilterModes
+    };
+
+    //Builds all the oversamplers for the given channels and host block size
+    void prepare(int numChannels, int maximumBlockSize);
+    void reset();
+
+    //Selects factor (as power of two) and filters, returns true if the setting changed
+    bool setMode(int factorIndex, FilterMode mode);
+
+    int getFactor() const noexcept { return 1 << currentFactor; }
+
+    //Latency of the active setting, always a whole number of samples
+    int getLatencyInSamples() const noexcept;
+
+    //Upsamples the block, calls nonLinear on the oversampled block and downsamples back in place
+    template <typename NonLinearFunction>
+    void process(juce::dsp::AudioBlock<float>& block, NonLinearFunction&& nonLinear)
+    {
+        auto* oversampler = getActive();
+
+        if (oversampler == nullptr) {
+            nonLinear(block);
+            return;
+        }
+
+        //The oversamplers buffers are sized for maxBlockSize samples
+        for (size_t start = 0; start < block.getNumSamples(); start += (size_t)maxBlockSize)
+        {
+            auto subBlock = block.getSubBlock(start, juce::jmin((size_t)maxBlockSize, block.getNumSamples() - start));
+            auto upsampled = oversampler->processSamplesUp(subBlock);
+            nonLinear(upsampled);
+            oversampler->processSamplesDown(subBlock);
+        }
+    }
+
+private:
+    juce::dsp::Oversampling<float>* getActive() const noexcept;
+
+    //Index 0 (1x) stays empty
+    std::array<std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, numFilterModes>, numFactors> oversamplers;
+
+    int currentFactor = 0;
+    FilterMode currentMode = polyphaseIIR;
+    int maxBlockSize = 0;
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    ParamSnapshot.cpp
+
+    Per block copy of the parameters, read through cached handles.
+
+  ==============================================================================
+*/
+
+#include "ParamSnapshot.h"
+
+ParameterHandles::ParameterHandles(juce::AudioProcessorValueTreeState& apvts)
+    : in(apvts.getRawParameterValue("IN")),
+      out(apvts.getRawParameterValue("OUT")),
+      drive(apvts.getRawParameterValue("DRIVE")),
+      drywet(apvts.getRawParameterValue("DRYWET")),
+      tone(apvts.getRawParameterValue("TONE")),
+      midSide(apvts.getRawParameterValue("MIDSIDE")),
+      clipper(apvts.getRawParameterValue("CLIPPER")),
+      distType(apvts.getRawParameterValue("DISTTYPE")),
+      oversampling(apvts.getRawParameterValue("OVERSAMPLING")),
+      osFilter(apvts.getRawParameterValue("OSFILTER")),
+      quality(apvts.getRawParameterValue("QUALITY")),
+      lookahead(apvts.getRawParameterValue("LOOKAHEAD")),
+      offlineHQ(apvts.getRawParameterValue("OFFLINEHQ")),
+      autoGain(apvts.getRawParameterValue("AUTOGAIN")),
+      bands(apvts.getRawParameterValue("BANDS"))
+{
+    for (size_t crossover = 0; crossover < crossovers.size(); crossover++)
+        crossovers[crossover] = apvts.getRawParameterValue("XOVER" + juce::String((int)crossover + 1));
+
+    for (size_t band = 0; band < (size_t)ParamSnapshot::maxBands; band++) {
+
+        const juce::String prefix = "BAND" + juce::String((int)band + 1);
+        bandType[band] = apvts.getRawParameterValue(prefix + "TYPE");
+        bandDrive[band] = apvts.getRawParameterValue(prefix + "DRIVE");
+        bandMix[band] = apvts.getRawParameterValue(prefix + "MIX");
+
+        jassert(bandType[band] != nullptr && bandDrive[band] != nullptr && bandMix[band] != nullptr);
+    }
+
+    //Every ID must exist in createParameters
+    jassert(in != nullptr && out != nullptr && drive != nullptr && drywet != nullptr && tone != nullptr);
+    jassert(midSide != nullptr && clipper != nullptr && distType != nullptr);
+    jassert(oversampling != nullptr && osFilter != nullptr && quality != nullptr && lookahead != nullptr && offlineHQ != nullptr && autoGain != nullptr);
+    jassert(bands != nullptr && std::find(crossovers.begin(), crossovers.end(), nullptr) == crossovers.end());
+}
+
+ParamSnapshot ParameterHandles::snapshot() const noexcept
+{
+    ParamSnapshot params;
+
+    params.input = juce::Decibels::decibelsToGain(in->load());
+    params.output = juce::Decibels::decibelsToGain(out->load());
+    params.drive = juce::Decibels::decibelsToGain(drive->load());
+    params.drywet = drywet->load() / 100.0f;
+    params.tonedb = tone->load();
+
+    params.distType = (int)distType->load();
+    params.oversampling = (int)oversampling->load();
+    params.osFilter = (int)osFilter->load();
+    params.quality = (int)quality->load();
+    params.lookahead = (int)lookahead->load();
+
+    params.midSide = midSide->load() > 0;
+    params.clipper = clipper->load() > 0;
+    params.offlineHQ = offlineHQ->load() > 0;
+    params.autoGain = autoGain->load() > 0;
+
+    params.numBands = (int)bands->load() + 1;
+
+    for (size_t crossover = 0; crossover < crossovers.size(); crossover++)
+        params.crossovers[crossover] = crossovers[crossover]->load();
+
+    for (size_t band = 0; band < (size_t)ParamSnapshot::maxBands; band++) {
+
+        params.bandType[band] = (int)bandType[band]->load();
+        params.bandDrive[band] = juce::Decibels::decibelsToGain(bandDrive[band]->load());
+        params.bandMix[band] = bandMix[band]->load() / 100.0f;
+    }
+
+    return params;
+}
+
+//==============================================================================
+void ParamSmoother::prepare(double sampleRate, const ParamSnapshot& params)
+{
+    inputGain.reset(sampleRate, rampSeconds);
+    outputGain.reset(sampleRate, rampSeconds);
+    driveGain.reset(sampleRate, rampSeconds);
+    drywetMix.reset(sampleRate, rampSeconds);
+    toneDecibels.reset(sampleRate, rampSeconds);
+
+    inputGain.setCurrentAndTargetValue(params.input);
+    outputGain.setCurrentAndTargetValue(params.output);
+    driveGain.setCurrentAndTargetValue(params.drive);
+    drywetMix.setCurrentAndTargetValue(params.drywet);
+    toneDecibels.setCurrentAndTargetValue(params.tonedb);
+
+    for (size_t band = 0; band < (size_t)ParamSnapshot::maxBands; band++) {
+
+        bandDriveGains[band].reset(sampleRate, rampSeconds);
+        bandMixes[band].reset(sampleRate, rampSeconds);
+        bandDriveGains[band].setCurrentAndTargetValue(params.bandDrive[band]);
+        bandMixes[band].setCurrentAndTargetValue(params.bandMix[band]);
+    }
+}
+
+void ParamSmoother::setTargets(const ParamSnapshot& params)
+{
+    inputGain.setTargetValue(params.input);
+    outputGain.setTargetValue(params.output);
+    driveGain.setTargetValue(params.drive);
+    drywetMix.setTargetValue(params.drywet);
+    toneDecibels.setTargetValue(params.tonedb);
+
+    for (size_t band = 0; band < (size_t)ParamSnapshot::maxBands; band++) {
+
+        bandDriveGains[band].setTargetValue(params.bandDrive[band]);
+        bandMixes[band].setTargetValue(params.bandMix[band]);
+    }
+}
+
+void ParamSmoother::advance(int numSamples, ParamSnapshot& params, Ramp& input, Ramp& output)
+{
+    jassert(numSamples <= subBlockSize);
+
+    input.start = inputGain.getCurrentValue();
+    input.end = inputGain.skip(numSamples);
+
+    output.start = outputGain.getCurrentValue();
+    output.end = outputGain.skip(numSamples);
+
+    //Held for the whole sub-block, at their value in the middle of it
+    params.drive = driveGain.skip(numSamples / 2);
+    params.drywet = drywetMix.skip(numSamples / 2);
+    params.tonedb = toneDecibels.skip(numSamples / 2);
+
+    driveGain.skip(numSamples - numSamples / 2);
+    drywetMix.skip(numSamples - numSamples / 2);
+    toneDecibels.skip(numSamples - numSamples / 2);
+
+    for (size_t band = 0; band < (size_t)ParamSnapshot::maxBands; band++) {
+
+        params.bandDrive[band] = bandDriveGains[band].skip(numSamples / 2);
+        params.bandMix[band] = bandMixes[band].skip(numSamples / 2);
+        bandDriveGains[band].skip(numSamples - numSamples / 2);
+        bandMixes[band].skip(numSamples - numSamples / 2);
+    }
+}
+
+void ParamSmoother::skip(int numSamples)
+{
+    inputGain.skip(numSamples);
+    outputGain.skip(numSamples);
+    driveGain.skip(numSamples);
+    drywetMix.skip(numSamples);
+    toneDecibels.skip(numSamples);
+
+    for (size_t band = 0; band < (size_t)ParamSnapshot::maxBands; band++) {
+
+        bandDriveGains[band].skip(numSamples);
+        bandMixes[band].skip(numSamples);
+    }
+}
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    ParamSnapshot.h
+
+    Per block copy of the parameters, read through cached handles.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Values of all the parameters for one block.
+
+    The processor takes one snapshot at the start of processBlock and passes
+    it down the chain, so every stage of the block sees the same values and
+    the dB to gain conversions happen once per block.
+*/
+struct ParamSnapshot
+{
+    //Bands of the multiband mode
+    static constexpr int maxBands = 4;
+
+    //IN, OUT and DRIVE as gains
+    float input = 1.0f;
+    float output = 1.0f;
+    float drive = 1.0f;
+
+    //DRYWET from 0 to 1
+    float drywet = 1.0f;
+
+    //TONE in dB, the filters are designed from it
+    float tonedb = 0.0f;
+
+    //Choice indices
+    int distType = 0;
+    int oversampling = 0;
+    int osFilter = 0;
+    int quality = 0;
+    int lookahead = 1;
+
+    bool midSide = false;
+    bool clipper = false;
+
+    //Higher quality settings when the host renders offline
+    bool offlineHQ = true;
+
+    //Output loudness matched to the input
+    bool autoGain = false;
+
+    //Multiband: BANDS as a count (1 is the single shaper), crossovers in Hz (ascending) and,
+    //per band, the algorithm, DRIVE as a gain and the mix from 0 to 1. The band drive and
+    //mix multiply DRIVE and DRYWET
+    int numBands = 1;
+    std::array<float, maxBands - 1> crossovers { { 200.0f, 1500.0f, 6000.0f } };
+    std::array<int, maxBands> bandType {};
+    std::array<float, maxBands> bandDrive { { 1.0f, 1.0f, 1.0f, 1.0f } };
+    std::array<float, maxBands> bandMix { { 1.0f, 1.0f, 1.0f, 1.0f } };
+};
+
+//==============================================================================
+/**
+    Raw parameter values, looked up by ID once at construction instead of at
+    every block.
+*/
+class ParameterHandles
+{
+public:
+    explicit ParameterHandles(juce::AudioProcessorValueTreeState& apvts);
+
+    //Reads every parameter once, lock free
+    ParamSnapshot snapshot() const noexcept;
+
+private:
+    std::atomic<float>* in;
+    std::atomic<float>* out;
+    std::atomic<float>* drive;
+    std::atomic<float>* drywet;
+    std::atomic<float>* tone;
+    std::atomic<float>* midSide;
+    std::atomic<float>* clipper;
+    std::atomic<float>* distType;
+    std::atomic<float>* oversampling;
+    std::atomic<float>* osFilter;
+    std::atomic<float>* quality;
+    std::atomic<float>* lookahead;
+    std::atomic<float>* offlineHQ;
+    std::atomic<float>* autoGain;
+    std::atomic<float>* bands;
+    std::array<std::atomic<float>*, ParamSnapshot::maxBands - 1> crossovers;
+    std::array<std::atomic<float>*, ParamSnapshot::maxBands> bandType, bandDrive, bandMix;
+};
+
+//==============================================================================
+/**
+    Smooths IN, OUT, DRIVE, DRYWET, TONE and the band DRIVE and mix towards
+    the values of the last snapshot.
+
+    The block is processed in sub-blocks of subBlockSize samples. IN and OUT
+    are applied as linear gain ramps inside every sub-block, while DRIVE,
+    DRYWET and TONE are held for the sub-block, so the shapers keep running
+    on constant values and the filters are redesigned at most once every
+    subBlockSize samples, whatever the host block size.
+*/
+class ParamSmoother
+{
+public:
+    static constexpr int subBlockSize = 32;
+
+    //Ramp time of every parameter
+    static constexpr double rampSeconds = 0.02;
+
+    //Gain ramp over a sub-block
+    struct Ramp
+    {
+        float start, end;
+    };
+
+    //Jumps to the values of the snapshot
+    void prepare(double sampleRate, const ParamSnapshot& params);
+
+    //New targets, once per block
+    void setTargets(const ParamSnapshot& params);
+
+    //Advances by numSamples (at most subBlockSize). The snapshot receives the
+    //held values for the sub-block, the ramps the gains at its start and end
+    void advance(int numSamples, ParamSnapshot& params, Ramp& input, Ramp& output);
+
+    //Advances by any number of samples without output, for skipped blocks
+    void skip(int numSamples);
+
+private:
+    //Gains move linearly in dB
+    using GainSmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    GainSmoother inputGain, outputGain, driveGain;
+    juce::SmoothedValue<float> drywetMix, toneDecibels;
+
+    std::array<GainSmoother, ParamSnapshot::maxBands> bandDriveGains;
+    std::array<juce::SmoothedValue<float>, ParamSnapshot::maxBands> bandMixes;
+};
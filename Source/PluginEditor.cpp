@@ -36,8 +36,8 @@ QuadRoughAudioProcessorEditor::QuadRoughAudioProcessorEditor (QuadRoughAudioProc
     ///DRIVE KNOB///
     driveknob.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
     driveknob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, true, 100, 20);
-    //call repaint to modify the curve displaied
-    driveknob.onValueChange = [this] {(repaint(), juce::dontSendNotification); };
+    //rebuild the curve displaied
+    driveknob.onValueChange = [this] { updateCurve(); };
     driveknob.setRange(0, 20.0, 0.1);
     driveknob.setTextValueSuffix(" dB");
     addAndMakeVisible(driveknob);
@@ -123,8 +123,8 @@ QuadRoughAudioProcessorEditor::QuadRoughAudioProcessorEditor (QuadRoughAudioProc
     distBox.addItem("PRISTINE", 2);
     distBox.addItem("HARD", 3);
     distBox.addItem("MAD", 4);
-    //call repaint to modify the curve displaied
-    distBox.onChange = [this] {(repaint(), juce::dontSendNotification); };
+    //rebuild the curve displaied
+    distBox.onChange = [this] { updateCurve(); };
     distBox.setJustificationType(juce::Justification::centred);
     addAndMakeVisible(distBox);
 
@@ -146,10 +146,32 @@ QuadRoughAudioProcessorEditor::QuadRoughAudioProcessorEditor (QuadRoughAudioProc
     drywetknob.setLookAndFeel(&customLookAndFeel);
     toneknob.setLookAndFeel(&customLookAndFeel);
     distBox.setLookAndFeel(&customLookAndFeel);
+
+    //CACHED IMAGES, the knobs are only redrawn when their value changes, not by the plot and meters
+    inputknob.setBufferedToImage(true);
+    outputknob.setBufferedToImage(true);
+    driveknob.setBufferedToImage(true);
+    drywetknob.setBufferedToImage(true);
+    toneknob.setBufferedToImage(true);
+
+   #if QUADROUGH_PROFILING
+    ///PROFILE LABEL, over the background, never in the way of the mouse
+    profileLabel.setJustificationType(juce::Justification::topLeft);
+    profileLabel.setColour(juce::Label::textColourId, juce::Colours::aliceblue.withAlpha(0.7f));
+    profileLabel.setInterceptsMouseClicks(false, false);
+    addAndMakeVisible(profileLabel);
+   #endif
+
+    //TELEMETRY, the processor publishes levels and curve points only while the editor is open
+    audioProcessor.getTelemetry().setActive(true);
+    startTimerHz(refreshRateHz);
 }
 
 QuadRoughAudioProcessorEditor::~QuadRoughAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.getTelemetry().setActive(false);
+
     //free the object from the LookAndFeel when the interface is destructed
     inputknob.setLookAndFeel(nullptr);
     outputknob.setLookAndFeel(nullptr);
@@ -170,77 +192,168 @@ void QuadRoughAudioProcessorEditor::paint(juce::Graphics& g)
     juce::Rectangle<int> plot(plot_x, plot_y - linew / 2, plot_w, plot_h + linew);
     g.setColour(juce::Colours::white);
     g.fillRect(plot);
-    g.setColour(juce::Colours::red);
-    float drivedb = driveknob.getValue();
-    float drive = juce::Decibels::decibelsToGain(drivedb);
+
+    //Built by updateCurve, PRISTINE goes above the plot and is cut at its edge
+    {
+        juce::Graphics::ScopedSaveState state(g);
+        g.reduceClipRegion(plot);
+        g.setColour(juce::Colours::red);
+        g.strokePath(curvePath, juce::PathStrokeType(linew));
+    }
+
+    paintScatter(g);
+    paintMeters(g);
+}
+
+void QuadRoughAudioProcessorEditor::updateCurve()
+{
+    float drive = juce::Decibels::decibelsToGain((float)driveknob.getValue());
     int f_type = distBox.getSelectedId();
-    float step_func = 0.05;
-    
-    //Tanh
-    if (f_type == 1) {
-        for (float ind = -1.5; ind < 1.5 - step_func; ind = ind + step_func) {
-            g.drawLine(plot_x + plot_w / 2 + plot_w * ind / 3,
-                plot_y + plot_h / 2 - plot_w * std::tanh(drive * ind) / 3,
-                plot_x + plot_w / 2 + plot_w * (ind + step_func) / 3,
-                plot_y + plot_h / 2 - plot_w * std::tanh(drive * (ind + step_func)) / 3,
-                linew);
-        }
+
+    //Inputs -1.5 to 1.5 through the kernel of the algorithm, fully wet
+    std::array<float, numCurvePoints> curve;
+
+    for (int i = 0; i < numCurvePoints; i++)
+        curve[(size_t)i] = -1.5f + 3.0f * i / (numCurvePoints - 1);
+
+    const auto& kernels = ShaperKernels::getBest();
+    const ShaperKernels::Kernel kernel = f_type == 2 ? kernels.pristine : f_type == 3 ? kernels.hard : f_type == 4 ? kernels.mad : kernels.classic;
+    kernel(curve.data(), numCurvePoints, drive, 1.0f);
+
+    //Same axes as before: plot_w / 3 pixels per unit on both, 0 at the centre
+    curvePath.clear();
+    curvePath.preallocateSpace(3 * numCurvePoints);
+
+    for (int i = 0; i < numCurvePoints; i++) {
+
+        float x = plot_x + plot_w / 2 + plot_w * (-1.5f + 3.0f * i / (numCurvePoints - 1)) / 3;
+        float y = plot_y + plot_h / 2 - plot_w * juce::jlimit(-1.1f, 1.1f, curve[(size_t)i]) / 3;
+
+        if (i == 0)
+            curvePath.startNewSubPath(x, y);
+        else
+            curvePath.lineTo(x, y);
     }
 
-    //Asymetric
-    else if (f_type == 2) {
-        float q = -0.05f;
-        float d = 7.0f;
-        for (float ind = -1.5; ind < 1.5 - step_func; ind = ind + step_func) {
-            float y = ((ind)*drive - q) / (1 - exp(-d * ((ind)*drive - q))) + q / (1 - exp(d * q));
-            float ystep = ((ind + step_func) * drive - q) / (1 - exp(-d * ((ind + step_func) * drive - q))) + q / (1 - exp(d * q));
-            if (ystep < 1.0f) {
-                g.drawLine(plot_x + plot_w / 2 + plot_w * ind / 3,
-                    plot_y + plot_h / 2 - plot_w * (y) / 3,
-                    plot_x + plot_w / 2 + plot_w * (ind + step_func) / 3,
-                    plot_y + plot_h / 2 - plot_w * (ystep) / 3,
-                    linew);
-            }
-            else if (y >= 1.0f - ystep && y < 1.0f) {
-                g.drawLine(plot_x + plot_w / 2 + plot_w * ind / 3,
-                    plot_y + plot_h / 2 - plot_w * (y) / 3,
-                    plot_x + plot_w / 2 + plot_w * (ind + step_func) / 3,
-                    plot_y + plot_h / 2 - plot_w * (1.05f) / 3,
-                    linew);
-            }
-        }
+    repaint(scopeArea);
+}
+
+void QuadRoughAudioProcessorEditor::timerCallback()
+{
+    auto& telemetry = audioProcessor.getTelemetry();
+
+    //Peaks fall by 20 dB per second, RMS and gain reduction follow the last frame
+    const float decay = juce::Decibels::decibelsToGain(-20.0f / refreshRateHz);
+    meterLevels.inputPeak *= decay;
+    meterLevels.outputPeak *= decay;
+
+    Telemetry::Levels levels;
+    bool received = false;
+
+    while (telemetry.popLevels(levels)) {
+
+        meterLevels.inputPeak = juce::jmax(meterLevels.inputPeak, levels.inputPeak);
+        meterLevels.outputPeak = juce::jmax(meterLevels.outputPeak, levels.outputPeak);
+
+        //Lowest gain of the frames since the last refresh
+        meterLevels.ceilingGain = received ? juce::jmin(meterLevels.ceilingGain, levels.ceilingGain) : levels.ceilingGain;
+        meterLevels.inputRms = levels.inputRms;
+        meterLevels.outputRms = levels.outputRms;
+        received = true;
     }
 
-    //HardClipping
-    else if (f_type == 3) {
-        g.drawLine(plot_x + plot_w / 2 + plot_w * (-1.5f) / 3,
-            plot_y + plot_h / 2 - plot_w * (-1.0f) / 3,
-            plot_x + plot_w / 2 + plot_w * (-1.0f / drive + 0.02f) / 3,
-            plot_y + plot_h / 2 - plot_w * (-1.0f) / 3,
-            linew);
-        g.drawLine(plot_x + plot_w / 2 + plot_w * (-1.0f / drive) / 3,
-            plot_y + plot_h / 2 - plot_w * (-1.0f) / 3,
-            plot_x + plot_w / 2 + plot_w * (1.0f / drive + 0.02f) / 3,
-            plot_y + plot_h / 2 - plot_w * (1.0f) / 3,
-            linew);
-        g.drawLine(plot_x + plot_w / 2 + plot_w * (1.0f / drive) / 3,
-            plot_y + plot_h / 2 - plot_w * (1.0f) / 3,
-            plot_x + plot_w / 2 + plot_w * (1.5f) / 3,
-            plot_y + plot_h / 2 - plot_w * (1.0f) / 3,
-            linew);
+    Telemetry::CurvePoint point;
+
+    while (telemetry.popCurvePoint(point)) {
 
+        scatterPoints[(size_t)scatterIndex] = point;
+        scatterIndex = (scatterIndex + 1) % (int)scatterPoints.size();
+        numScatterPoints = juce::jmin(numScatterPoints + 1, (int)scatterPoints.size());
     }
 
-    //Sinusoidal FoldBack
-    else if (f_type == 4) {
-        for (float ind = -1.5; ind < 1.5 - step_func; ind = ind + step_func) {
-            g.drawLine(plot_x + plot_w / 2 + plot_w * ind / 3,
-                plot_y + plot_h / 2 - plot_w * (ind + std::sin(4 * ind * drive)) * 0.25 / 3,
-                plot_x + plot_w / 2 + plot_w * (ind + step_func) / 3,
-                plot_y + plot_h / 2 - plot_w * (ind + step_func + std::sin(4 * (ind + step_func) * drive)) * 0.25 / 3,
-                linew);
-        }
+    repaint(scopeArea);
+
+   #if QUADROUGH_PROFILING
+    if (++profileFrames >= refreshRateHz / 2) {
+        updateProfile();
+        profileFrames = 0;
     }
+   #endif
+}
+
+#if QUADROUGH_PROFILING
+void QuadRoughAudioProcessorEditor::updateProfile()
+{
+    auto& profiler = audioProcessor.getProfiler();
+    juce::String text;
+
+    //Microseconds per sub-block of a group, per host block for the whole block
+    for (int stage = 0; stage < StageProfiler::numStages; stage++)
+    {
+        const auto summary = profiler.getSummary(stage);
+
+        if (summary.count == 0)
+            continue;
+
+        text << StageProfiler::getStageName(stage)
+             << "  " << juce::String(summary.p50, 1)
+             << " / " << juce::String(summary.p99, 1)
+             << " / " << juce::String(summary.max, 1) << " us\n";
+    }
+
+    profileLabel.setText(text.isEmpty() ? "idle" : "p50 / p99 / max\n" + text, juce::dontSendNotification);
+    profiler.reset();
+}
+#endif
+
+void QuadRoughAudioProcessorEditor::paintScatter(juce::Graphics& g)
+{
+    //Same axes as the curve: +-1.5 in, plot_w / 3 pixels per unit
+    const float dot = juce::jmax(2.0f, plot_w / 80.0f);
+    g.setColour(juce::Colours::darkred.withAlpha(0.5f));
+
+    for (int i = 0; i < numScatterPoints; i++) {
+
+        const auto& point = scatterPoints[(size_t)i];
+
+        if (std::abs(point.input) > 1.5f)
+            continue;
+
+        float x = plot_x + plot_w / 2 + plot_w * point.input / 3;
+        float y = plot_y + plot_h / 2 - plot_w * juce::jlimit(-1.0f, 1.0f, point.output) / 3;
+        g.fillEllipse(x - dot / 2, y - dot / 2, dot, dot);
+    }
+}
+
+void QuadRoughAudioProcessorEditor::paintMeters(juce::Graphics& g)
+{
+    //-60 dBFS at the bottom, 0 dBFS at the top of the plot
+    const float meterWidth = plot_w / 20;
+    const float gap = meterWidth;
+
+    auto toHeight = [this](float gain) {
+        float db = juce::Decibels::gainToDecibels(gain, -60.0f);
+        return plot_h * juce::jlimit(0.0f, 1.0f, (db + 60.0f) / 60.0f);
+    };
+
+    auto drawMeter = [&](float x, float peak, float rms) {
+        g.setColour(juce::Colour(64, 64, 64));
+        g.fillRect(x, plot_y, meterWidth, plot_h);
+
+        g.setColour(juce::Colours::aliceblue.withAlpha(0.5f));
+        g.fillRect(x, plot_y + plot_h - toHeight(peak), meterWidth, toHeight(peak));
+
+        g.setColour(juce::Colours::aliceblue);
+        g.fillRect(x, plot_y + plot_h - toHeight(rms), meterWidth, toHeight(rms));
+    };
+
+    drawMeter(plot_x - gap - meterWidth, meterLevels.inputPeak, meterLevels.inputRms);
+    drawMeter(plot_x + plot_w + gap, meterLevels.outputPeak, meterLevels.outputRms);
+
+    //Ceiling gain reduction, 0 to 12 dB down from the top of the output meter
+    float reductionDb = -juce::Decibels::gainToDecibels(meterLevels.ceilingGain, -12.0f);
+    g.setColour(juce::Colours::red);
+    g.fillRect(plot_x + plot_w + gap, plot_y, meterWidth, plot_h * juce::jlimit(0.0f, 1.0f, reductionDb / 12.0f));
 }
 
 void QuadRoughAudioProcessorEditor::resized()
@@ -302,9 +415,20 @@ void QuadRoughAudioProcessorEditor::resized()
     distBox.setBounds(centerX - width * 0.2 / 2, height * 0.82, width * 0.2, height * 0.143);
     distBox.setJustificationType(4);
 
+   #if QUADROUGH_PROFILING
+    ///PROFILE, left of the M/S button
+    profileLabel.setBounds(0, 0, width * 0.22, height * 0.3);
+    profileLabel.setFont(juce::Font(fontscaler * 0.45f));
+   #endif
+
     ///PLOT DISTORTION FUNCTION
     plot_w = width * 0.2;
     plot_h = width * 0.2 / 3 * 2;
     plot_x = centerX - plot_w / 2;
     plot_y = height * 0.58;
+
+    //Plot, line width and the meters on both sides
+    scopeArea = juce::Rectangle<float>(plot_x - plot_w / 10, plot_y - 3, plot_w * 1.2f, plot_h + 6).getSmallestIntegerContainer();
+
+    updateCurve();
 }
@@ -23,13 +23,13 @@ public:
     //KNOBS
     void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPos, float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider) override
     {
-        float diameter = juce::jmin(width, height);
+        float diameter = (float)juce::jmin(width, height);
         float radius = diameter / 2;
-        float centerX = x + width / 2;
-        float centerY = y + height / 2;
+        float centerX = (float)(x + width / 2);
+        float centerY = (float)(y + height / 2);
         float rx = centerX - radius;
         float ry = centerY - radius;
-        float angle = rotaryStartAngle + (sliderPos * (rotaryEndAngle - rotaryStartAngle));
+        juce::ignoreUnused(rotaryStartAngle, rotaryEndAngle, slider);
 
         //Updating Variable according to sliderPos
         float vardiamter = diameter * sliderPos;
@@ -49,6 +49,7 @@ public:
 
 
         /*///PATH TICK
+        float angle = rotaryStartAngle + (sliderPos * (rotaryEndAngle - rotaryStartAngle));
         juce::Path knobTick;
         knobTick.addRectangle(0, -radius, 2.0f, radius * 0.33);
         g.fillPath(knobTick, juce::AffineTransform::rotation(angle).translated(centerX, centerY));
@@ -118,6 +119,8 @@ public:
         const juce::String& shortcutKeyText,
         const juce::Drawable* icon, const juce::Colour* const textColourToUse) override
     {
+        juce::ignoreUnused(isTicked, textColourToUse);
+
         if (isSeparator)
         {
             auto r = area.reduced(5, 0);
@@ -143,7 +146,7 @@ public:
             }
             else
             {
-                g.setColour(juce::Colour(32, 32, 32));
+                g.setColour(textColour);
             }
 
             r.reduce(juce::jmin(5, area.getWidth() / 20), 0);
@@ -197,7 +200,8 @@ public:
 };
 
 
-class QuadRoughAudioProcessorEditor  : public juce::AudioProcessorEditor
+class QuadRoughAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                       private juce::Timer
 {
 public:
     QuadRoughAudioProcessorEditor (QuadRoughAudioProcessor&);
@@ -210,7 +214,30 @@ public:
     //Variables for the plot
     float plot_w, plot_h, plot_x, plot_y;
 
+    //Meters and scatter refresh rate
+    static constexpr int refreshRateHz = 30;
+
+    //Points of the transfer curve, over inputs -1.5 to 1.5
+    static constexpr int numCurvePoints = 241;
+
 private:
+    //Rebuilds the transfer curve when DRIVE, the algorithm or the size change, and repaints the plot
+    void updateCurve();
+
+    //Reads the telemetry of the processor and repaints the plot and meters
+    void timerCallback() override;
+
+    //Input and output meters beside the plot, gain reduction of the ceiling from the top of the output one
+    void paintMeters(juce::Graphics&);
+
+    //Last points of the shaper curve, over the plot
+    void paintScatter(juce::Graphics&);
+
+   #if QUADROUGH_PROFILING
+    //p50, p99 and max of every stage since the last update, then starts a new window
+    void updateProfile();
+   #endif
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     QuadRoughAudioProcessor& audioProcessor;
@@ -250,5 +277,24 @@ private:
 
     CustomLookAndFeel customLookAndFeel;
 
+    //Transfer curve in editor coordinates, from the same kernels as the audio
+    juce::Path curvePath;
+
+    //Levels shown by the meters, peaks falling at a constant rate
+    Telemetry::Levels meterLevels;
+
+    //Ring of the last curve points received
+    std::array<Telemetry::CurvePoint, 256> scatterPoints;
+    int scatterIndex = 0, numScatterPoints = 0;
+
+    //Plot and meters, the only area repainted by the timer
+    juce::Rectangle<int> scopeArea;
+
+   #if QUADROUGH_PROFILING
+    //Stage timings, top left, refreshed twice per second
+    juce::Label profileLabel;
+    int profileFrames = 0;
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (QuadRoughAudioProcessorEditor)
 };
@@ -20,25 +20,17 @@ QuadRoughAudioProcessor::QuadRoughAudioProcessor()
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        ), apvts(*this, nullptr, "Parameters", createParameters()),
-    //PRE Filters
-    PreLowPass(juce::dsp::IIR::Coefficients<float>::makeLowPass(44100, 20000.0f, 0.1)),
-    PreHighPass(juce::dsp::IIR::Coefficients<float>::makeHighPass(44100, 20.0f, 0.1)),
-    PreLowShelf(juce::dsp::IIR::Coefficients<float>::makeLowShelf(44100, 144.0f, 0.1, 1.0f)),
-    PreHighShelf(juce::dsp::IIR::Coefficients<float>::makeHighShelf(44100, 2773.0f, 0.1, 1.0f)),
-    PreMidBell(juce::dsp::IIR::Coefficients<float>::makePeakFilter(44100, 755.0f, 0.1, 1.0f)),
-
-    //POST Filters
-    PostLowPass(juce::dsp::IIR::Coefficients<float>::makeLowPass(44100, 20000.0f, 0.1)),
-    PostHighPass(juce::dsp::IIR::Coefficients<float>::makeHighPass(44100, 20.0f, 0.1)),
-    PostLowShelf(juce::dsp::IIR::Coefficients<float>::makeLowShelf(44100, 144.0f, 0.1, 1.0f)),
-    PostHighShelf(juce::dsp::IIR::Coefficients<float>::makeHighShelf(44100, 2773.0f, 0.1, 1.0f)),
-    PostMidBell(juce::dsp::IIR::Coefficients<float>::makePeakFilter(44100, 755.0f, 0.1, 1.0f))
+    //Parameter handles, resolved once
+    parameterHandles(apvts),
+    pluginState(*this, apvts.state.getType()),
+    presets(pluginState)
 #endif
 {
 }
 
 QuadRoughAudioProcessor::~QuadRoughAudioProcessor()
 {
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -76,31 +68,55 @@ bool QuadRoughAudioProcessor::isMidiEffect() const
 
 double QuadRoughAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    //Time for the filters and the oversampling to decay to -120 dB
+    return tailSeconds.load();
 }
 
 int QuadRoughAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return presets.getNumPresets();
 }
 
 int QuadRoughAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return presets.getCurrent();
 }
 
 void QuadRoughAudioProcessor::setCurrentProgram (int index)
 {
+    presets.select(index);
+
+    //Parameters are set and the host notified on the message thread only. Some hosts change
+    //the program from the audio thread, the preset is then applied by handleAsyncUpdate
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        applyPendingPreset();
+    else
+        triggerAsyncUpdate();
+}
+
+void QuadRoughAudioProcessor::applyPendingPreset()
+{
+    if (auto* preset = presets.takePending())
+        pluginState.apply(*preset);
+}
+
+void QuadRoughAudioProcessor::handleAsyncUpdate()
+{
+    applyPendingPreset();
 }
 
 const juce::String QuadRoughAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (index < 0 || index >= presets.getNumPresets())
+        return {};
+
+    return presets.getName(index);
 }
 
 void QuadRoughAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    //Factory presets are read only
+    juce::ignoreUnused(index, newName);
 }
 
 //==============================================================================
@@ -108,39 +124,82 @@ void QuadRoughAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBl
 {
     //Filters preparation
 
-    lastSampleRate = sampleRate;
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = getTotalNumOutputChannels();
-    
-    //PRE Filters
-    PreLowPass.prepare(spec);
-    PreHighPass.prepare(spec);
-    PreLowShelf.prepare(spec);
-    PreHighShelf.prepare(spec);
-    PreMidBell.prepare(spec);
-
-    //POST Filters
-    PostLowPass.prepare(spec);
-    PostHighPass.prepare(spec);
-    PostLowShelf.prepare(spec);
-    PostHighShelf.prepare(spec);
-    PostMidBell.prepare(spec);
-
-    //PRE Filters Reset
-    PreLowPass.reset();
-    PreHighPass.reset();
-    PreLowShelf.reset();
-    PreHighShelf.reset();
-    PreMidBell.reset();
-
-    //POST Filters Reset
-    PostLowPass.reset();
-    PostHighPass.reset();
-    PostLowShelf.reset();
-    PostHighShelf.reset();
-    PostMidBell.reset();
+    lastSampleRate = (float)sampleRate;
+
+    //One chain per pair and per single channel of the layout, a stereo bus is one pair
+    groups.clear();
+
+    for (auto& channels : ChannelGroup::getLayoutGroups(getChannelLayoutOfBus(true, 0)))
+        groups.push_back(std::make_unique<ChannelGroup>(channels));
+
+    if (groups.empty())
+        groups.push_back(std::make_unique<ChannelGroup>(ChannelGroup::Channels { 0, -1 }));
+
+    //Filters, oversampling, shapers and limiter of every group
+    for (auto& group : groups)
+        group->prepare(sampleRate, samplesPerBlock);
+
+    //The host sets the offline state before preparing, the latency reported here is the one of the mode
+    auto params = parameterHandles.snapshot();
+    heldParams = params;
+    applyRenderMode(params);
+
+    //Smoothed parameters start from the current values
+    smoother.prepare(sampleRate, params);
+
+    //Longest tail of the two cascades over the TONE range, measured once for this samplerate
+    auto& first = *groups.front();
+    const auto toneRange = apvts.getParameterRange("TONE");
+    filterTailSamples = 0;
+
+    toneCoefficients.prepare(sampleRate);
+
+    for (float tonedb : { toneRange.start, 0.0f, toneRange.end })
+    {
+        toneCoefficients.update(tonedb);
+        first.setFilterCoefficients(toneCoefficients.getCoefficients());
+
+        int tail = first.preTone.getTailSamples(-SilenceDetector::thresholdDb, (int)(10.0 * sampleRate))
+                 + first.postTone.getTailSamples(-SilenceDetector::thresholdDb, (int)(10.0 * sampleRate));
+        filterTailSamples = juce::jmax(filterTailSamples, tail);
+    }
+
+    //Every group starts from the current TONE, the schedule only carries the changes
+    toneCoefficients.update(params.tonedb);
+
+    for (auto& group : groups)
+        group->setFilterCoefficients(toneCoefficients.getCoefficients());
+
+    //Oversampling factor, limiter lookahead and crossovers of the parameters
+    updateOversampling(params);
+    updateLookahead(params);
+    ceilingActive = params.clipper;
+    updateLatency(params);
+    updateMultiband(params);
+
+    //Sub-block settings for the longest block, longer ones are processed in parts
+    schedule.resize((size_t)juce::jmax(1, (samplesPerBlock + ParamSmoother::subBlockSize - 1) / ParamSmoother::subBlockSize));
+
+    //Worker threads for the groups beyond the first, a few at most, the audio thread takes a group too
+    const int automaticThreads = juce::jmin(3, juce::SystemStats::getNumCpus() - 1);
+    const int threads = maxWorkerThreads >= 0 ? maxWorkerThreads : automaticThreads;
+    workers.setNumThreads(juce::jmin(threads, (int)groups.size() - 1));
+
+    //Auto gain keeps its matched level across prepares
+    autoGain.prepare(sampleRate);
+
+    //Meter frames at the new samplerate
+    telemetry.prepare(sampleRate);
+
+   #if QUADROUGH_PROFILING
+    //Timings of the new samplerate and block size only
+    profiler.reset();
+   #endif
+
+    //Silence detection starts from a running track
+    silence.reset();
+    idle = false;
+    updateTailLength();
 }
 
 void QuadRoughAudioProcessor::releaseResources()
@@ -156,12 +215,12 @@ bool QuadRoughAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout up to ChannelGroup::maxChannels: mono, stereo, surround up to 9.1.6,
+    // ambisonics up to 3rd order and discrete buses. The channels are grouped in
+    // pairs and single channels, see ChannelGroup::getLayoutGroups.
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output.isDisabled() || output.size() > ChannelGroup::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -175,292 +234,666 @@ bool QuadRoughAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
 }
 #endif
 
+//True if the two channels are the same within -120 dB, stops at the first chunk that differs
+template <typename SampleType>
+static bool isDualMono(const juce::AudioBuffer<SampleType>& buffer, int leftChannel, int rightChannel) noexcept
+{
+    constexpr SampleType tolerance = (SampleType)1.0e-6;
+    constexpr int chunkSize = 64;
+
+    const SampleType* left = buffer.getReadPointer(leftChannel);
+    const SampleType* right = buffer.getReadPointer(rightChannel);
+    const int numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += chunkSize) {
+
+        const int end = juce::jmin(numSamples, start + chunkSize);
+        SampleType difference = 0;
+
+        for (int i = start; i < end; i++)
+            difference = juce::jmax(difference, std::abs(left[i] - right[i]));
+
+        if (difference > tolerance)
+            return false;
+    }
+
+    return true;
+}
+
 void QuadRoughAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+void QuadRoughAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+bool QuadRoughAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void QuadRoughAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
+    QUADROUGH_PROFILE_SCOPE(profiler, block);
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    //Create a context to pass to filters
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-
-    //Retrive values from components
-    float inputdb = *apvts.getRawParameterValue("IN");
-    float outputdb = *apvts.getRawParameterValue("OUT");
-    float input = juce::Decibels::decibelsToGain(inputdb);
-    float output = juce::Decibels::decibelsToGain(outputdb);
-    float combo = *apvts.getRawParameterValue("DISTTYPE");
-    float midsidebtn = *apvts.getRawParameterValue("MIDSIDE");
-    float clipbtn = *apvts.getRawParameterValue("CLIPPER");
-    float tonedb = *apvts.getRawParameterValue("TONE");
-    float postone = juce::Decibels::decibelsToGain(tonedb);
-    float negtone = juce::Decibels::decibelsToGain(-tonedb);
-
-    //Prefilters Init
-    *PreLowPass.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(lastSampleRate, 22000.0f, 0.1);
-    *PreHighPass.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(lastSampleRate, 18.0f, 0.1);
-    *PreLowShelf.state = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(lastSampleRate, 144.0f, 0.5, postone);
-    *PreHighShelf.state = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(lastSampleRate, 2773.0f, 0.5, postone);
-    *PreMidBell.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(lastSampleRate, 755.0f, 1, negtone);
-
-    //Postfilters Init
-    *PostLowPass.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(lastSampleRate, 22000.0f, 0.1);
-    *PostHighPass.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(lastSampleRate, 18.0f, 0.1);
-    *PostLowShelf.state = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(lastSampleRate, 144.0f, 0.5, negtone);
-    *PostHighShelf.state = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(lastSampleRate, 2773.0f, 0.5, negtone);
-    *PostMidBell.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(lastSampleRate, 755.0f, 1, postone );
-
-    buffer.applyGain(input);
-
-    //SAFE FILTERS
-    PreLowPass.process(context);
-    PreHighPass.process(context);
-
-    //PREFILTERING
-    PreHighShelf.process(context);
-    PreLowShelf.process(context);
-    PreMidBell.process(context);
+    //Retrive values from components, once for the whole block. While a preset or a state is
+    //being applied on the message thread the block keeps the values of the last one, so no
+    //block sees half of it
+    const auto applyCount = pluginState.getApplyCount();
+    auto params = parameterHandles.snapshot();
 
-    //DISTORTION
-    if (midsidebtn > 0 && totalNumInputChannels == 2) {
-        processMidSide(buffer);
+    if ((applyCount & 1) != 0 || pluginState.getApplyCount() != applyCount)
+        params = heldParams;
+    else
+        heldParams = params;
+    applyRenderMode(params);
+    smoother.setTargets(params);
+
+    //Oversampling factor and filters, the host is told when the latency changes,
+    //also when it switches between live and offline rendering without preparing again
+    bool latencyChanged = updateOversampling(params);
+
+    //The limiter starts from silence when CEILING is switched on, with the delay of the new lookahead
+    latencyChanged = updateLookahead(params) || latencyChanged;
+
+    if (params.clipper != ceilingActive) {
+        for (auto& group : groups)
+            group->ceilingLimiter.reset();
+
+        ceilingActive = params.clipper;
+        latencyChanged = true;
     }
-    else {
-        processJointChannels(buffer);
+
+    //QUALITY changes the latency too, without any stage changing its mode
+    if (updateLatency(params) || latencyChanged)
+        updateTailLength();
+
+    //Crossovers at the rate of the shapers, the tail follows the lowest one
+    if (updateMultiband(params))
+        updateTailLength();
+
+    //Input meters, nothing is measured without an editor
+    const bool metering = telemetry.isActive();
+
+    if (metering)
+        telemetry.beginBlock(buffer, totalNumInputChannels);
+
+    //Idle track: the input is silent and so are the tails of the last sound, nothing to compute
+    if (silence.isIdle(buffer, totalNumInputChannels)) {
+
+        if (!idle) {
+            //Every history is below -120 dB, resume from exact zeros
+            for (auto& group : groups)
+                group->reset();
+
+            idle = true;
+        }
+
+        smoother.skip(buffer.getNumSamples());
+        buffer.clear();
+        skippedBlocks++;
+
+        //The meters fall to silence
+        if (metering)
+            telemetry.endBlock(buffer, totalNumOutputChannels, 1.0f);
+
+        return;
     }
-    
-    //POST FILTERING
-    PostHighShelf.process(context);
-    PostLowShelf.process(context);
-    PostMidBell.process(context);
 
-    //SAFE FILTERS
-    PostLowPass.process(context);
-    PostHighPass.process(context);
+    idle = false;
+
+    //Loudness of the input, before anything touches the buffer
+    if (params.autoGain)
+        autoGain.beginBlock(buffer, totalNumInputChannels);
+
+    //Dual mono: identical channels go through the chain once, on the left, copied to the right at the end.
+    //M/S of identical channels has a silent side, the same single channel path gives the same result.
+    //Not with oversampling, the state of its filters cannot be copied between channels
+    auto& first = *groups.front();
+    const bool dualMono = groups.size() == 1 && first.isPair() && first.oversampling.getFactor() == 1
+                       && isDualMono(buffer, first.getChannel(0), first.getChannel(1));
+
+    //Short sub-blocks, so the smoothed parameters move during long host blocks. The settings of
+    //every sub-block are computed first, then every group runs them on its own: on the worker
+    //pool for long blocks of several groups, one after the other otherwise
+    const int numSamples = buffer.getNumSamples();
+    const int partSamples = (int)schedule.size() * ParamSmoother::subBlockSize;
+    const bool parallel = workers.getNumThreads() > 0 && numSamples >= parallelBlockSize;
+
+    for (int start = 0; start < numSamples; start += partSamples)
+    {
+        const int numSubBlocks = fillSchedule(params, juce::jmin(partSamples, numSamples - start));
+
+        auto processIndex = [this, &buffer, start, numSubBlocks, &params, dualMono](int index) {
+            processGroup(*groups[(size_t)index], buffer, start, numSubBlocks, params, dualMono);
+        };
+
+        if (parallel) {
+            workers.run((int)groups.size(), processIndex);
+        }
+        else {
+            for (int index = 0; index < (int)groups.size(); index++)
+                processIndex(index);
+        }
+    }
 
-    //CEILING OUTPUT
-    if (clipbtn > 0) {
-        finalceiling(buffer);
+    if (dualMono) {
+        //Right follows the left, output and histories, so it can leave dual mono without a click
+        buffer.copyFrom(first.getChannel(1), 0, buffer, first.getChannel(0), 0, numSamples);
+        first.copyChannelState();
+        dualMonoBlocks++;
     }
-    else {
-        buffer.applyGain(output);
+
+    if (params.autoGain) {
+        for (auto& group : groups)
+            autoGain.addOutput(group->autoGainOutput);
+
+        autoGain.endBlock();
     }
+
+    //Output meters and the lowest ceiling gain of the groups, reset at every block so an editor opens with fresh values
+    float ceilingGain = 1.0f;
+
+    for (auto& group : groups)
+        ceilingGain = juce::jmin(ceilingGain, group->ceilingLimiter.getAndResetLowestGain());
+
+    if (metering)
+        telemetry.endBlock(buffer, totalNumOutputChannels, ceilingActive ? ceilingGain : 1.0f);
 }
 
-void QuadRoughAudioProcessor::processJointChannels(juce::AudioBuffer<float>& buffer)
+int QuadRoughAudioProcessor::fillSchedule(const ParamSnapshot& params, int numSamples)
 {
-    float combo = *apvts.getRawParameterValue("DISTTYPE");
+    int numSubBlocks = 0;
 
-    if (combo == 0) {
-        //CLASSIC
-        tanhDistortion(buffer);
-    }
-    else if (combo == 1) {
-        //PRISTINE
-        asymDistortion(buffer);
-    }
-    else if (combo == 2) {
-        //HARD
-        hardclippingDistortion(buffer);
-    }
-    else if (combo == 3) {
-        //MAD
-        foldSinDistortion(buffer);
+    for (int start = 0; start < numSamples; start += ParamSmoother::subBlockSize)
+    {
+        auto& settings = schedule[(size_t)numSubBlocks++];
+        settings.numSamples = juce::jmin(ParamSmoother::subBlockSize, numSamples - start);
+
+        //Values held for the sub-block, gains ramped inside it
+        settings.params = params;
+        settings.makeup = { 1.0f, 1.0f };
+        smoother.advance(settings.numSamples, settings.params, settings.input, settings.output);
+
+        if (params.autoGain)
+            settings.makeup = autoGain.advance(settings.numSamples);
+
+        //Filter coefficients, designed only when the smoothed TONE or the samplerate change
+        settings.toneChanged = toneCoefficients.update(settings.params.tonedb);
+
+        if (settings.toneChanged)
+            settings.tone = toneCoefficients.getCoefficients();
     }
+
+    return numSubBlocks;
 }
 
-void QuadRoughAudioProcessor::processMidSide(juce::AudioBuffer<float>& buffer)
+template <typename SampleType>
+void QuadRoughAudioProcessor::processGroup(ChannelGroup& group, juce::AudioBuffer<SampleType>& buffer, int startSample, int numSubBlocks,
+                                           const ParamSnapshot& params, bool dualMono)
 {
+    //Worker threads too
+    juce::ScopedNoDenormals noDenormals;
 
-    int numSamples = buffer.getNumSamples();
-    juce::AudioSampleBuffer midBuffer, sideBuffer;
+    //Dual mono runs the left channel only
+    const int numChannels = dualMono ? 1 : group.getNumChannels();
 
-    float combo = *apvts.getRawParameterValue("DISTTYPE");
-    float drivedb = *apvts.getRawParameterValue("DRIVE");
-    float drive = juce::Decibels::decibelsToGain(drivedb);
+    //Chain specialised for the algorithm and the buttons of this block, M/S on pairs only
+    const bool midSide = params.midSide && group.isPair() && !dualMono;
+    const auto* processors = &getSubBlockProcessors<SampleType>()[(size_t)getSubBlockIndex(params.distType, midSide, params.clipper, false)];
 
-    if (midBuffer.getNumSamples() != numSamples)
+    for (int index = 0; index < numSubBlocks; index++)
     {
-        midBuffer.setSize(2, numSamples, false, true, true);
-        sideBuffer.setSize(2, numSamples, false, true, true);
-    }
+        const auto& settings = schedule[(size_t)index];
+        auto subBlock = group.getBlock(buffer, numChannels, startSample, settings.numSamples);
 
-    //retrive Left and Right Buffer
-    float* left = buffer.getWritePointer(0);
-    float* right = buffer.getWritePointer(1);
+        //Filters coefficients of the schedule, every group sees every change
+        if (settings.toneChanged)
+            group.setFilterCoefficients(settings.tone);
 
-    //Mid Buffer
-    midBuffer.copyFrom(0, 0, left, numSamples);
-    juce::FloatVectorOperations::add(midBuffer.getWritePointer(0), right, numSamples);
-    juce::FloatVectorOperations::multiply(midBuffer.getWritePointer(0), 0.5f, numSamples);
+        //DRYWET may reach 100% in the middle of a ramp
+        auto processor = processors[settings.params.drywet >= 1.0f ? 1 : 0];
+        (this->*processor)(group, subBlock, settings);
 
-    //Side Buffer
-    sideBuffer.copyFrom(0, 0, left, numSamples);
-    juce::FloatVectorOperations::subtract(sideBuffer.getWritePointer(0), right, numSamples);
-    juce::FloatVectorOperations::multiply(sideBuffer.getWritePointer(0), 0.5f, numSamples);
+        startSample += settings.numSamples;
+    }
+}
 
-    //Distortion to Mid
-    if (combo == 0) {
-        //CLASSIC
-        tanhDistortion(midBuffer);
+template <typename SampleType, int algorithm, bool midSide, bool ceiling, bool fullyWet>
+void QuadRoughAudioProcessor::processSubBlock(ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& block, const SubBlockSettings& settings)
+{
+    const auto& params = settings.params;
+    const auto& input = settings.input;
+    const auto& output = settings.output;
+    const auto& makeup = settings.makeup;
+    auto& postTone = group.getPostTone<SampleType>();
+
+    //INPUT GAIN + SAFE FILTERS + PREFILTERING, one pass
+    {
+        QUADROUGH_PROFILE_SCOPE(profiler, preFilters);
+        group.getPreTone<SampleType>().processWithInputGain(block, input.start, input.end);
     }
-    else if (combo == 1) {
-        //PRISTINE
-        asymDistortion(midBuffer);
+
+    //DISTORTION
+    if (midSide) {
+        processMidSide<SampleType, algorithm, fullyWet>(group, block, params);
     }
-    else if (combo == 2) {
-        //HARD
-        hardclippingDistortion(midBuffer);
+    else {
+        processJointChannels<SampleType, algorithm, fullyWet>(group, block, params);
     }
-    else if (combo == 3) {
-        //MAD
-        foldSinDistortion(midBuffer);
+
+    //POST FILTERING + SAFE FILTERS, then the true peak CEILING limiter + OUTPUT GAIN.
+    //The auto gain makeup goes before the limiter, which then works on the matched level.
+    //The makeup and OUT are divided out of the measured output, the chain alone is measured
+    if (ceiling) {
+        {
+            QUADROUGH_PROFILE_SCOPE(profiler, postFilters);
+
+            if (params.autoGain) {
+                postTone.processWithInputGain(block, makeup.start, makeup.end);
+                AutoGain::measureOutput(group.autoGainOutput, block, makeup.start, makeup.end);
+            }
+            else {
+                postTone.process(block);
+            }
+        }
+
+        QUADROUGH_PROFILE_SCOPE(profiler, ceiling);
+        processCeiling(group, block, output);
     }
+    else {
+        QUADROUGH_PROFILE_SCOPE(profiler, postFilters);
 
-    //Left after processing
-    juce::FloatVectorOperations::clear(left, numSamples);
-    juce::FloatVectorOperations::add(left, midBuffer.getWritePointer(0), numSamples);
-    juce::FloatVectorOperations::add(left, sideBuffer.getWritePointer(0), numSamples);
+        const ParamSmoother::Ramp gain { output.start * makeup.start, output.end * makeup.end };
+        postTone.processWithOutputGain(block, gain.start, gain.end);
 
-    //Right After processing
-    juce::FloatVectorOperations::clear(right, numSamples);
-    juce::FloatVectorOperations::add(right, midBuffer.getWritePointer(0), numSamples);
-    juce::FloatVectorOperations::subtract(right, sideBuffer.getWritePointer(0), numSamples);
+        if (params.autoGain)
+            AutoGain::measureOutput(group.autoGainOutput, block, gain.start, gain.end);
+    }
 }
 
-void QuadRoughAudioProcessor::tanhDistortion(juce::AudioBuffer<float>& buffer)
+int QuadRoughAudioProcessor::getSubBlockIndex(int algorithm, bool midSide, bool ceiling, bool fullyWet) noexcept
 {
-    auto totalNumInputChannels = getTotalNumInputChannels();
+    return juce::jlimit(0, numAlgorithms - 1, algorithm) * 8 + (midSide ? 4 : 0) + (ceiling ? 2 : 0) + (fullyWet ? 1 : 0);
+}
 
-    //Retrive parameter values
-    float drivedb = *apvts.getRawParameterValue("DRIVE");
-    float drywetprc = *apvts.getRawParameterValue("DRYWET");
-    float drywet = drywetprc / 100.0f;
-    float drive = juce::Decibels::decibelsToGain(drivedb);
+template <typename SampleType, size_t... indices>
+static std::array<QuadRoughAudioProcessor::SubBlockProcessor<SampleType>, sizeof...(indices)> makeSubBlockProcessors(std::index_sequence<indices...>)
+{
+    //Same bit layout as getSubBlockIndex
+    return { { &QuadRoughAudioProcessor::processSubBlock<SampleType, (int)(indices / 8), (indices & 4) != 0, (indices & 2) != 0, (indices & 1) != 0>... } };
+}
 
-    for (auto channel = 0; channel < totalNumInputChannels; channel++)
+template <typename SampleType>
+const std::array<QuadRoughAudioProcessor::SubBlockProcessor<SampleType>, QuadRoughAudioProcessor::numSubBlockProcessors>& QuadRoughAudioProcessor::getSubBlockProcessors()
+{
+    static const auto processors = makeSubBlockProcessors<SampleType>(std::make_index_sequence<numSubBlockProcessors>());
+    return processors;
+}
+
+void QuadRoughAudioProcessor::processCeiling(ChannelGroup& group, juce::dsp::AudioBlock<float>& block, const ParamSmoother::Ramp& output)
+{
+    group.ceilingLimiter.process(block, output.start, output.end);
+}
+
+void QuadRoughAudioProcessor::processCeiling(ChannelGroup& group, juce::dsp::AudioBlock<double>& block, const ParamSmoother::Ramp& output)
+{
+    processAsFloat(group, block, [&group, &output](juce::dsp::AudioBlock<float>& floatBlock) {
+        group.ceilingLimiter.process(floatBlock, output.start, output.end);
+    });
+}
+
+template <typename Function>
+void QuadRoughAudioProcessor::processAsFloat(ChannelGroup& group, juce::dsp::AudioBlock<double>& block, Function&& process)
+{
+    auto& doubleScratch = group.doubleScratch;
+    jassert(block.getNumChannels() <= (size_t)doubleScratch.getNumChannels() && block.getNumSamples() <= (size_t)doubleScratch.getNumSamples());
+
+    const size_t numSamples = block.getNumSamples();
+    auto scratch = juce::dsp::AudioBlock<float>(doubleScratch).getSubsetChannelBlock(0, block.getNumChannels()).getSubBlock(0, numSamples);
+
+    for (size_t channel = 0; channel < block.getNumChannels(); channel++)
     {
-        auto* channelData = buffer.getWritePointer(channel);
+        const double* source = block.getChannelPointer(channel);
+        float* destination = scratch.getChannelPointer(channel);
 
-        for (auto i = 0; i < buffer.getNumSamples(); i++) {
+        for (size_t i = 0; i < numSamples; i++)
+            destination[i] = (float)source[i];
+    }
 
-            channelData[i] = channelData[i] * (1 - drywet) + std::tanh(channelData[i] * drive) * std::tanh(4 / drive) * drywet;
-        }
+    process(scratch);
+
+    for (size_t channel = 0; channel < block.getNumChannels(); channel++)
+    {
+        const float* source = scratch.getChannelPointer(channel);
+        double* destination = block.getChannelPointer(channel);
+
+        for (size_t i = 0; i < numSamples; i++)
+            destination[i] = (double)source[i];
+    }
+}
+
+void QuadRoughAudioProcessor::updateTailLength()
+{
+    //Same settings in every group
+    const auto& group = *groups.front();
+    const auto& oversampling = group.oversampling;
+
+    //Oversampling: group delay of the up and down filters, plus a margin for the IIR allpasses to ring out
+    int oversamplingTail = oversampling.getFactor() > 1 ? 2 * oversampling.getLatencyInSamples() + 64 : 0;
+
+    //Two samples of ADAA history between the cascades, the crossovers and the limiter delay line
+    int tailSamples = filterTailSamples + oversamplingTail + 2 + group.multiband.getTailSamples(lastSampleRate)
+                    + (ceilingActive ? group.ceilingLimiter.getLatencyInSamples() : 0);
+
+    silence.setTailSamples(tailSamples);
+    tailSeconds.store(tailSamples / (double)lastSampleRate);
+}
+
+bool QuadRoughAudioProcessor::updateLatency(const ParamSnapshot& params)
+{
+    //Same in every group
+    const auto& group = *groups.front();
+    int latency = group.oversampling.getLatencyInSamples() + (params.clipper ? group.ceilingLimiter.getLatencyInSamples() : 0);
+
+    //The ADAA delay is counted at the rate of the shapers, whole host samples only without oversampling
+    if (group.oversampling.getFactor() == 1)
+        latency += AdaaShaper::getLatencyInSamples(params.quality);
+
+    if (latency == getLatencySamples())
+        return false;
+
+    setLatencySamples(latency);
+    return true;
+}
+
+void QuadRoughAudioProcessor::applyRenderMode(ParamSnapshot& params)
+{
+    if (isNonRealtime() && params.offlineHQ) {
+        //No deadline: highest factor, longest linear phase filters, no approximations
+        params.oversampling = OversamplingStage::numFactors - 1;
+        params.osFilter = OversamplingStage::renderFIR;
+        shaperKernels = &ShaperKernels::getScalar();
+    }
+    else {
+        shaperKernels = &ShaperKernels::getBest();
     }
 }
 
-void QuadRoughAudioProcessor::hardclippingDistortion(juce::AudioBuffer<float>& buffer)
+bool QuadRoughAudioProcessor::updateOversampling(const ParamSnapshot& params)
+{
+    bool changed = false;
+
+    for (auto& group : groups)
+        changed = group->oversampling.setMode(params.oversampling, (OversamplingStage::FilterMode)params.osFilter) || changed;
+
+    return changed;
+}
+
+bool QuadRoughAudioProcessor::updateLookahead(const ParamSnapshot& params)
 {
-    auto totalNumInputChannels = getTotalNumInputChannels();
+    bool changed = false;
 
-    //Retrive parameter values
-    float drivedb = *apvts.getRawParameterValue("DRIVE");
-    float drywetprc = *apvts.getRawParameterValue("DRYWET");
-    float drywet = drywetprc / 100.0f;
-    float drive = juce::Decibels::decibelsToGain(drivedb);
-    
-    //fixed threshold
-    float threshold = 1.0f;
+    for (auto& group : groups)
+        changed = group->ceilingLimiter.setLookahead(params.lookahead) || changed;
 
-    for (auto channel = 0; channel < totalNumInputChannels; channel++)
+    return changed;
+}
+
+bool QuadRoughAudioProcessor::updateMultiband(const ParamSnapshot& params)
+{
+    //Ascending, a third of an octave apart at least, below the host Nyquist
+    const float highest = 0.45f * lastSampleRate;
+    auto crossovers = params.crossovers;
+    float lowest = 20.0f;
+
+    for (auto& frequency : crossovers)
     {
+        frequency = juce::jmin(highest, juce::jmax(lowest, frequency));
+        lowest = frequency * 1.26f;
+    }
 
-        auto* channelData = buffer.getWritePointer(channel);
+    bool changed = false;
 
-        for (auto i = 0; i < buffer.getNumSamples(); i++) {
+    for (auto& group : groups)
+    {
+        const int previousBands = group->multiband.getNumBands();
 
-            if (channelData[i] * drive > threshold) {
-                channelData[i] = channelData[i] * (1 - drywet) + threshold*drywet;
-            }
-            else if (channelData[i] * drive < -threshold) {
-                channelData[i] = channelData[i] * (1 - drywet) + (-threshold*drywet);
-            }
-            else {
-                channelData[i] = channelData[i] * (1 - drywet) + channelData[i] * drive * drywet;
-            }
+        if (!group->multiband.setCrossovers((double)lastSampleRate * group->oversampling.getFactor(), crossovers, params.numBands))
+            continue;
+
+        //The band shapers restart with the bands
+        if (group->multiband.getNumBands() != previousBands) {
+            for (auto& shaper : group->bandAdaa)
+                shaper.reset();
         }
+
+        changed = true;
     }
+
+    return changed;
 }
 
-void QuadRoughAudioProcessor::asymDistortion(juce::AudioBuffer<float>& buffer)
+template <typename SampleType, int algorithm, bool fullyWet>
+void QuadRoughAudioProcessor::processJointChannels(ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& block, const ParamSnapshot& params)
 {
-    auto totalNumInputChannels = getTotalNumInputChannels();
+    //Every channel of the group goes through the shaper, only the left one for dual mono
+    QUADROUGH_PROFILE_SCOPE(profiler, shaper);
+    processNonlinear<algorithm, fullyWet>(group, block, params, false);
+}
 
-    //Retrive parameter values
-    float drivedb = *apvts.getRawParameterValue("DRIVE");
-    float drywetprc = *apvts.getRawParameterValue("DRYWET");
-    float drywet = drywetprc / 100.0f;
-    float drive = juce::Decibels::decibelsToGain(drivedb);
-    
-    //Fixed parameters for distortion shapes
-    float q = -0.05f;
-    float d = 7.0f;
+template <typename SampleType, int algorithm, bool fullyWet>
+void QuadRoughAudioProcessor::processMidSide(ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& audio, const ParamSnapshot& params)
+{
+    int numSamples = (int)audio.getNumSamples();
 
-    for (auto channel = 0; channel < totalNumInputChannels; channel++)
+    //retrive Left and Right Buffer
+    SampleType* left = audio.getChannelPointer(0);
+    SampleType* right = audio.getChannelPointer(1);
+
+    //Encode in place: left becomes Mid, right becomes Side
     {
-        auto* channelData = buffer.getWritePointer(channel);
+        QUADROUGH_PROFILE_SCOPE(profiler, midSideEncode);
 
-        for (auto i = 0; i < buffer.getNumSamples(); i++) {
+        for (auto i = 0; i < numSamples; i++) {
 
-            channelData[i] = channelData[i] * (1 - drywet) +  ((channelData[i] * drive - q) / (1 - exp(-d * (channelData[i] * drive - q))) + q / (1 - exp(d * q)))*drywet;
+            SampleType mid = (left[i] + right[i]) * (SampleType)0.5;
+            SampleType side = (left[i] - right[i]) * (SampleType)0.5;
+            left[i] = mid;
+            right[i] = side;
         }
     }
+
+    //Distortion to Mid only. Side goes through the oversampling filters and the ADAA delay too,
+    //so the decode sums two signals with the same latency
+    {
+        QUADROUGH_PROFILE_SCOPE(profiler, shaper);
+
+        juce::dsp::AudioBlock<SampleType> block = audio.getSubsetChannelBlock(0, 2);
+        processNonlinear<algorithm, fullyWet>(group, block, params, true);
+    }
+
+    //Decode in place: Left = Mid + Side, Right = Mid - Side
+    QUADROUGH_PROFILE_SCOPE(profiler, midSideDecode);
+
+    for (auto i = 0; i < numSamples; i++) {
+
+        SampleType mid = left[i];
+        SampleType side = right[i];
+        left[i] = mid + side;
+        right[i] = mid - side;
+    }
 }
 
-void QuadRoughAudioProcessor::foldSinDistortion(juce::AudioBuffer<float>& buffer)
+template <int algorithm, bool fullyWet>
+void QuadRoughAudioProcessor::processNonlinear(ChannelGroup& group, juce::dsp::AudioBlock<float>& block, const ParamSnapshot& params, bool midOnly)
 {
-    auto totalNumInputChannels = getTotalNumInputChannels();
+    group.oversampling.process(block, [this, &group, &params, midOnly](juce::dsp::AudioBlock<float>& upsampled) {
+        if (group.multiband.getNumBands() > 1) {
+            processBands(group, upsampled, params, midOnly);
+            return;
+        }
 
-    //Retrive parameter values
-    float drivedb = *apvts.getRawParameterValue("DRIVE");
-    float drywetprc = *apvts.getRawParameterValue("DRYWET");
-    float drywet = drywetprc / 100.0f;
-    float drive = juce::Decibels::decibelsToGain(drivedb);
-    
-    //Factor to "speed" the distortion
-    float factor = 4.0f;
+        juce::dsp::AudioBlock<float> shaped = midOnly ? upsampled.getSingleChannelBlock(0) : upsampled;
+        processDistortion<float, algorithm, fullyWet>(group, shaped, params);
+
+        //Side is not shaped, only delayed like the dry Mid: half a sample (ADAA1) or one (ADAA2)
+        if (midOnly && params.quality > 0)
+            group.adaa.delayChannel(upsampled, 1, (AdaaShaper::Order)params.quality);
+    });
+}
+
+template <int algorithm, bool fullyWet>
+void QuadRoughAudioProcessor::processNonlinear(ChannelGroup& group, juce::dsp::AudioBlock<double>& block, const ParamSnapshot& params, bool midOnly)
+{
+    if (group.oversampling.getFactor() == 1 && params.quality == 0 && group.multiband.getNumBands() < 2) {
 
-    for (auto channel = 0; channel < totalNumInputChannels; channel++)
+        juce::dsp::AudioBlock<double> shaped = midOnly ? block.getSingleChannelBlock(0) : block;
+        processDistortion<double, algorithm, fullyWet>(group, shaped, params);
+        return;
+    }
+
+    processAsFloat(group, block, [this, &group, &params, midOnly](juce::dsp::AudioBlock<float>& floatBlock) {
+        processNonlinear<algorithm, fullyWet>(group, floatBlock, params, midOnly);
+    });
+}
+
+//True if every sample is within +-1 (the HARD threshold), SIMD peak scan
+static bool isWithinUnity(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    for (size_t channel = 0; channel < block.getNumChannels(); channel++)
     {
+        auto range = juce::FloatVectorOperations::findMinAndMax(block.getChannelPointer(channel), (int)block.getNumSamples());
+
+        if (range.getStart() < -1.0f || range.getEnd() > 1.0f)
+            return false;
+    }
 
-        auto* channelData = buffer.getWritePointer(channel);
+    return true;
+}
+
+template <typename SampleType, int algorithm, bool fullyWet>
+void QuadRoughAudioProcessor::processDistortion(ChannelGroup& group, juce::dsp::AudioBlock<SampleType>& block, const ParamSnapshot& params)
+{
+    //Exactly 1 when fully wet, the kernels then skip the mix
+    const float drywet = fullyWet ? 1.0f : params.drywet;
+
+    //One point of the curve per call for the editor scatter, from the middle of the block. The input
+    //is taken where the ADAA output is centred: half a sample (ADAA1) or one sample (ADAA2) earlier.
+    //Only the first group writes to the scatter, its FIFO has a single producer
+    const bool capture = telemetry.isActive() && &group == groups.front().get() && block.getNumSamples() > 1;
+    const size_t index = block.getNumSamples() / 2;
+    float input = 0.0f;
+
+    if (capture) {
+        const SampleType* samples = block.getChannelPointer(0);
+
+        if (params.quality == 0)
+            input = (float)samples[index];
+        else if (params.quality == 1)
+            input = (float)(0.5 * (samples[index - 1] + samples[index]));
+        else
+            input = (float)samples[index - 1];
+    }
 
-        for (auto i = 0; i < buffer.getNumSamples(); i++) {
+    processShaper(block, algorithm, params.drive, drywet, params.quality, group.adaa);
 
-            channelData[i] = channelData[i] * (1 - drywet) + (channelData[i] + std::sin(factor * channelData[i] * drive)) * 0.25 * drywet;
-        }
+    if (capture)
+        telemetry.addCurvePoint(input, (float)block.getChannelPointer(0)[index]);
+}
+
+void QuadRoughAudioProcessor::processBands(ChannelGroup& group, juce::dsp::AudioBlock<float>& block, const ParamSnapshot& params, bool midOnly)
+{
+    //Side is split too: the bands sum to an allpass, which Mid and Side need alike for the decode
+    auto& multiband = group.multiband;
+    multiband.split(block);
+
+    //The band DRIVE and mix scale the main ones, the drive stays in the DRIVE range (0 to 20 dB).
+    //A band at 0 mix is not shaped, only summed back
+    for (int band = 0; band < multiband.getNumBands(); band++)
+    {
+        auto bandBlock = multiband.getBand(band);
+        auto shaped = midOnly ? bandBlock.getSingleChannelBlock(0) : bandBlock;
+        const float drive = juce::jlimit(1.0f, 10.0f, params.drive * params.bandDrive[(size_t)band]);
+
+        processShaper(shaped, params.bandType[(size_t)band], drive, params.drywet * params.bandMix[(size_t)band],
+                      params.quality, group.bandAdaa[(size_t)band]);
+
+        //The Side band is not shaped, only delayed like the dry Mid band
+        if (midOnly && params.quality > 0)
+            group.bandAdaa[(size_t)band].delayChannel(bandBlock, 1, (AdaaShaper::Order)params.quality);
     }
+
+    multiband.sum(block);
 }
 
-void QuadRoughAudioProcessor::finalceiling(juce::AudioBuffer<float>& buffer)
+void QuadRoughAudioProcessor::processShaper(juce::dsp::AudioBlock<float>& block, int algorithm, float drive, float drywet, int quality, AdaaShaper& shaper)
 {
-    auto totalNumInputChannels = getTotalNumInputChannels();
+    algorithm = juce::jlimit(0, numAlgorithms - 1, algorithm);
+
+    if (quality > 0) {
+        //ADAA1 / ADAA2, always run: the dry signal is delayed with the wet one
+        shaper.process(block, algorithm, (AdaaShaper::Order)quality, drive, drywet);
+        return;
+    }
+
+    //Short-circuits, the kernel would give back its input: fully dry, or HARD at 0 dB
+    //DRIVE with every sample below the threshold, where it is the identity
+    if (drywet <= 0.0f) {
+        bypassedShaperBlocks++;
+        return;
+    }
+
+    if (algorithm == 2 && juce::approximatelyEqual(drive, 1.0f) && isWithinUnity(block)) {
+        bypassedShaperBlocks++;
+        return;
+    }
 
-    //Retrive output value
-    float outputdb = *apvts.getRawParameterValue("OUT");
-    float output = juce::Decibels::decibelsToGain(outputdb);
+    //CLASSIC, PRISTINE, HARD, MAD
+    static constexpr ShaperKernels::Kernel ShaperKernels::Table::* kernels[] = { &ShaperKernels::Table::classic, &ShaperKernels::Table::pristine,
+                                                                                 &ShaperKernels::Table::hard, &ShaperKernels::Table::mad };
+    const auto kernel = shaperKernels->*kernels[algorithm];
 
-    for (auto channel = 0; channel < totalNumInputChannels; channel++)
+    for (size_t channel = 0; channel < block.getNumChannels(); channel++)
     {
+        kernel(block.getChannelPointer(channel), (int)block.getNumSamples(), drive, drywet);
+    }
+}
 
-        auto* channelData = buffer.getWritePointer(channel);
+void QuadRoughAudioProcessor::processShaper(juce::dsp::AudioBlock<double>& block, int algorithm, float drive, float drywet, int quality, AdaaShaper&)
+{
+    //processNonlinear sends ADAA to the float shapers
+    jassert(quality == 0);
+    juce::ignoreUnused(quality);
 
-        for (auto i = 0; i < buffer.getNumSamples(); i++) {
+    algorithm = juce::jlimit(0, numAlgorithms - 1, algorithm);
 
-            if (channelData[i] > 1.0f) {
-                channelData[i] = output;
-            }
-            else if (channelData[i] < -1.0f) {
-                channelData[i] = -output;
-            }
-            else {
-                channelData[i] = channelData[i] * output;
-            }
-        }
+    if (drywet <= 0.0f) {
+        bypassedShaperBlocks++;
+        return;
+    }
+
+    //CLASSIC, PRISTINE, HARD, MAD
+    using Table = ShaperKernels::KernelTable<double>;
+    static constexpr Table::Kernel Table::* kernels[] = { &Table::classic, &Table::pristine, &Table::hard, &Table::mad };
+    const auto kernel = ShaperKernels::getScalarDouble().*kernels[algorithm];
+
+    for (size_t channel = 0; channel < block.getNumChannels(); channel++)
+    {
+        kernel(block.getChannelPointer(channel), (int)block.getNumSamples(), (double)drive, (double)drywet);
     }
 }
 
@@ -478,15 +911,28 @@ juce::AudioProcessorEditor* QuadRoughAudioProcessor::createEditor()
 //==============================================================================
 void QuadRoughAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    //Every parameter in the binary format of PluginState, also a preset for quadrough-render
+    auto values = pluginState.capture();
+
+    //Matched level of the auto gain, so a recalled session starts there without measuring again
+    values.autoGainDb = autoGain.getGainDecibels();
+    values.hasAutoGain = true;
+
+    pluginState.write(values, destData);
 }
 
 void QuadRoughAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    //Binary state, or the XML of earlier versions
+    PluginState::Values values;
+
+    if (!pluginState.read(data, sizeInBytes, values))
+        return;
+
+    if (values.hasAutoGain)
+        autoGain.setGainDecibels(values.autoGainDb);
+
+    pluginState.apply(values);
 }
 
 //==============================================================================
@@ -508,6 +954,32 @@ juce::AudioProcessorValueTreeState::ParameterLayout QuadRoughAudioProcessor::cre
     parameters.push_back(std::make_unique<juce::AudioParameterBool>("MIDSIDE", "MidSide Button", false));
     parameters.push_back(std::make_unique<juce::AudioParameterBool>("CLIPPER", "Clipper Button", false));
     parameters.push_back(std::make_unique<juce::AudioParameterChoice>("DISTTYPE", "Distortion Type", juce::StringArray("CLASSIC", "PRISTINE", "HARD", "MAD"), 0));
+    //Host parameters from here on, no control on the interface (see the README)
+    parameters.push_back(std::make_unique<juce::AudioParameterChoice>("OVERSAMPLING", "Oversampling", juce::StringArray("1X", "2X", "4X", "8X"), 0));
+    parameters.push_back(std::make_unique<juce::AudioParameterChoice>("OSFILTER", "Oversampling Filter", juce::StringArray("IIR", "FIR"), 0));
+    parameters.push_back(std::make_unique<juce::AudioParameterChoice>("QUALITY", "Quality", juce::StringArray("STANDARD", "ADAA1", "ADAA2"), 0));
+    parameters.push_back(std::make_unique<juce::AudioParameterBool>("OFFLINEHQ", "Offline HQ Button", true));
+    parameters.push_back(std::make_unique<juce::AudioParameterChoice>("LOOKAHEAD", "Ceiling Lookahead", juce::StringArray("0.5 MS", "1.5 MS", "5 MS"), 1));
+    parameters.push_back(std::make_unique<juce::AudioParameterBool>("AUTOGAIN", "Auto Gain Button", false));
+
+    //Multiband: up to three crossovers, algorithm, drive and mix per band
+    parameters.push_back(std::make_unique<juce::AudioParameterChoice>("BANDS", "Bands", juce::StringArray("1", "2", "3", "4"), 0));
+
+    const float crossovers[] = { 200.0f, 1500.0f, 6000.0f };
+
+    for (int crossover = 0; crossover < ParamSnapshot::maxBands - 1; crossover++)
+    {
+        parameters.push_back(std::make_unique<juce::AudioParameterFloat>("XOVER" + juce::String(crossover + 1), "Crossover " + juce::String(crossover + 1),
+                                                                         juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), crossovers[crossover]));
+    }
+
+    for (int band = 1; band <= ParamSnapshot::maxBands; band++)
+    {
+        parameters.push_back(std::make_unique<juce::AudioParameterChoice>("BAND" + juce::String(band) + "TYPE", "Band " + juce::String(band) + " Type",
+                                                                          juce::StringArray("CLASSIC", "PRISTINE", "HARD", "MAD"), 0));
+        parameters.push_back(std::make_unique<juce::AudioParameterFloat>("BAND" + juce::String(band) + "DRIVE", "Band " + juce::String(band) + " Drive", -20.0f, 20.0f, 0.0f));
+        parameters.push_back(std::make_unique<juce::AudioParameterFloat>("BAND" + juce::String(band) + "MIX", "Band " + juce::String(band) + " Mix", 0.0f, 100.0f, 100.0f));
+    }
 
 
     return { parameters.begin(), parameters.end() };
@@ -9,11 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ShaperKernels.h"
+#include "ParamSnapshot.h"
+#include "SilenceDetector.h"
+#include "ChannelGroup.h"
+#include "WorkerPool.h"
+#include "Telemetry.h"
+#include "PluginState.h"
+#include "StageProfiler.h"
 
 //==============================================================================
 /**
 */
-class QuadRoughAudioProcessor  : public juce::AudioProcessor
+class QuadRoughAudioProcessor  : public juce::AudioProcessor,
+                                 private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -30,6 +39,10 @@ public:
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+    //64 bit hosts: the filters, M/S and shapers run in double, see processSamples
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -53,35 +66,202 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    //Processing equally LR channels
-    void processJointChannels(juce::AudioBuffer<float>&);
+    //CLASSIC, PRISTINE, HARD, MAD
+    static constexpr int numAlgorithms = 4;
+
+    //Both processBlocks, float or double. The block level work (parameters, idle and dual mono
+    //detection, meters, auto gain) is shared; the sub-blocks run the chain in the sample type
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>&);
+
+    //Smoothed parameters and gain ramps of one sub-block, the same for every channel group
+    struct SubBlockSettings
+    {
+        ParamSnapshot params;
+        ParamSmoother::Ramp input, output, makeup;
+        int numSamples = 0;
+
+        //Filter coefficients of the smoothed TONE, designed once for all the groups, valid when toneChanged
+        ToneCoefficientManager::Coefficients tone;
+        bool toneChanged = false;
+    };
+
+    //Advances the smoothers over numSamples samples, one entry of schedule per sub-block. Returns the count
+    int fillSchedule(const ParamSnapshot&, int numSamples);
+
+    //Every sub-block of the schedule through one group, startSample onwards. Any thread,
+    //the groups of a block run on the worker pool when it is long enough
+    template <typename SampleType>
+    void processGroup(ChannelGroup&, juce::AudioBuffer<SampleType>&, int startSample, int numSubBlocks, const ParamSnapshot&, bool dualMono);
+
+    //Whole chain for one sub-block of a group, specialised for the algorithm and the buttons so the
+    //compiler removes the branches. The sub-block stays in L1 cache between the three passes:
+    //input gain + filters, distortion, filters + ceiling + auto gain makeup + output gain
+    template <typename SampleType, int algorithm, bool midSide, bool ceiling, bool fullyWet>
+    void processSubBlock(ChannelGroup&, juce::dsp::AudioBlock<SampleType>&, const SubBlockSettings&);
+
+    //Every specialisation of processSubBlock for a sample type, picked with getSubBlockIndex
+    template <typename SampleType>
+    using SubBlockProcessor = void (QuadRoughAudioProcessor::*)(ChannelGroup&, juce::dsp::AudioBlock<SampleType>&, const SubBlockSettings&);
+    static constexpr int numSubBlockProcessors = numAlgorithms * 8;
+
+    template <typename SampleType>
+    static const std::array<SubBlockProcessor<SampleType>, numSubBlockProcessors>& getSubBlockProcessors();
+    static int getSubBlockIndex(int algorithm, bool midSide, bool ceiling, bool fullyWet) noexcept;
+
+    //Processing equally every channel of the group
+    template <typename SampleType, int algorithm, bool fullyWet>
+    void processJointChannels(ChannelGroup&, juce::dsp::AudioBlock<SampleType>&, const ParamSnapshot&);
+
+    //Splitting Mid and Side of a pair, in place
+    template <typename SampleType, int algorithm, bool fullyWet>
+    void processMidSide(ChannelGroup&, juce::dsp::AudioBlock<SampleType>&, const ParamSnapshot&);
+
+    //Oversampling around the shapers or the multiband split. With midOnly only the first channel
+    //is shaped, the others go through the oversampling filters too to keep the same latency
+    template <int algorithm, bool fullyWet>
+    void processNonlinear(ChannelGroup&, juce::dsp::AudioBlock<float>&, const ParamSnapshot&, bool midOnly);
+
+    //Double precision: the shapers run in double at 1x with STANDARD quality and one band. The
+    //oversampling, ADAA and the crossovers only exist in float, they run through the scratch buffer
+    template <int algorithm, bool fullyWet>
+    void processNonlinear(ChannelGroup&, juce::dsp::AudioBlock<double>&, const ParamSnapshot&, bool midOnly);
+
+    //Applies the algorithm to every channel of the block, with ADAA if QUALITY asks for it
+    template <typename SampleType, int algorithm, bool fullyWet>
+    void processDistortion(ChannelGroup&, juce::dsp::AudioBlock<SampleType>&, const ParamSnapshot&);
+
+    //Multiband: splits the block, shapes every band with its own algorithm, DRIVE and mix, sums back.
+    //midOnly: the second channel (Side) is split and summed unshaped, with the same allpass and ADAA delay
+    void processBands(ChannelGroup&, juce::dsp::AudioBlock<float>&, const ParamSnapshot&, bool midOnly);
+
+    //One shaper on every channel of the block, the kernels or the given ADAA shaper.
+    //Skipped when it would give back its input
+    void processShaper(juce::dsp::AudioBlock<float>&, int algorithm, float drive, float drywet, int quality, AdaaShaper&);
+
+    //Same in double precision, with the std:: maths. STANDARD quality only, ADAA runs in float
+    void processShaper(juce::dsp::AudioBlock<double>&, int algorithm, float drive, float drywet, int quality, AdaaShaper&);
+
+    //True peak CEILING limiter and OUTPUT gain, in float: a double block goes through the scratch buffer
+    void processCeiling(ChannelGroup&, juce::dsp::AudioBlock<float>&, const ParamSmoother::Ramp& output);
+    void processCeiling(ChannelGroup&, juce::dsp::AudioBlock<double>&, const ParamSmoother::Ramp& output);
+
+    //Runs a float stage on a double sub-block, converted to and from the scratch buffer of the group
+    template <typename Function>
+    void processAsFloat(ChannelGroup&, juce::dsp::AudioBlock<double>&, Function&& process);
+
+    //Tail of the filters, oversampling and shaper histories, for the silence detector and the host
+    void updateTailLength();
+
+    //Oversampling latency, plus the limiter lookahead while CEILING is on and the sample of ADAA2
+    //without oversampling. The half sample of ADAA1, and the ADAA delay inside the oversampling
+    //(a fraction of a host sample), cannot be reported. Returns true if it changed
+    bool updateLatency(const ParamSnapshot&);
+
+    //Blocks skipped because the input and the tails were silent
+    juce::int64 getNumSkippedBlocks() const noexcept { return skippedBlocks.load(); }
+
+    //Sub-blocks where the shaper was bypassed: DRYWET at 0, or HARD at 0 dB DRIVE below the threshold
+    juce::int64 getNumBypassedShaperBlocks() const noexcept { return bypassedShaperBlocks.load(); }
 
-    //Splitting Mid and Side
-    void processMidSide(juce::AudioBuffer<float>&);
+    //Stereo blocks with identical channels, processed once
+    juce::int64 getNumDualMonoBlocks() const noexcept { return dualMonoBlocks.load(); }
 
-    //Ceiling the output level
-    void finalceiling(juce::AudioBuffer<float>&);
+    //Meters and curve scatter for the editor, published only while it is active
+    Telemetry& getTelemetry() noexcept { return telemetry; }
 
-    //Tanh Algorithm
-    void tanhDistortion(juce::AudioBuffer<float>&);
+   #if QUADROUGH_PROFILING
+    //Timing histograms of the stages, for the editor and the bench
+    StageProfiler& getProfiler() noexcept { return profiler; }
+   #endif
+
+    //Offline HQ: when the host renders offline, switches to 8x render FIR oversampling
+    //and the exact std:: maths. Live, the fastest kernels and the user oversampling
+    void applyRenderMode(ParamSnapshot&);
+
+    //Select the oversampling from the parameters, returns true if it changed
+    bool updateOversampling(const ParamSnapshot&);
+
+    //Bands and crossovers at the rate of the shapers, returns true if they changed
+    bool updateMultiband(const ParamSnapshot&);
+
+    //LOOKAHEAD of every limiter, returns true if it changed
+    bool updateLookahead(const ParamSnapshot&);
+
+    //Largest number of worker threads for the channel groups, -1 (default) picks it from the
+    //number of cores. Taken at the next prepareToPlay
+    void setMaxWorkerThreads(int maxThreads) noexcept { maxWorkerThreads = maxThreads; }
 
-    //FoldSin Distortion
-    void foldSinDistortion(juce::AudioBuffer<float>&);
+    //Channel groups of the prepared layout
+    int getNumChannelGroups() const noexcept { return (int)groups.size(); }
 
-    //Triode algorithm
-    void asymDistortion(juce::AudioBuffer<float>&);
+    //Host blocks from this length run the groups on the worker pool, shorter ones on the audio thread alone
+    static constexpr int parallelBlockSize = 1024;
 
-    //Hard Clipping
-    void hardclippingDistortion(juce::AudioBuffer<float>&);
+    //Applies the preset selected since the last call. Message thread
+    void applyPendingPreset();
 
     //Value tree state Paramters
     juce::AudioProcessorValueTreeState apvts;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
 private:
-    //IIR filters 
-    using Filter = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>>;
-    Filter PreLowPass, PreHighPass, PreLowShelf, PreHighShelf, PreMidBell, PostLowPass, PostHighPass, PostLowShelf, PostHighShelf, PostMidBell;
+    //Preset selected from another thread than the message thread
+    void handleAsyncUpdate() override;
+
+    //Parameters read once per block
+    ParameterHandles parameterHandles;
+
+    //Binary state, and the factory presets, applied on the message thread by applyPendingPreset
+    PluginState pluginState;
+    PresetBank presets;
+
+    //Values of the last block, kept while a preset or a state is being applied
+    ParamSnapshot heldParams;
+
+    //IN, OUT, DRIVE, DRYWET and TONE ramps
+    ParamSmoother smoother;
+
+    //Filters, oversampling, shapers and limiter of every pair and single channel of the bus,
+    //built for the layout in prepareToPlay
+    std::vector<std::unique_ptr<ChannelGroup>> groups;
+
+    //Runs the groups of long blocks in parallel
+    WorkerPool workers;
+    int maxWorkerThreads = -1;
+
+    //Sub-block settings of the current block, sized for the prepared block size
+    std::vector<SubBlockSettings> schedule;
+
+    //PRE/POST coefficients of the last scheduled TONE, the groups copy the designs of the schedule
+    ToneCoefficientManager toneCoefficients;
+
+    //Block kernels of the four algorithms, chosen by CPU features live and exact offline
+    const ShaperKernels::Table* shaperKernels = &ShaperKernels::getBest();
+
+    //CEILING button
+    bool ceilingActive = false;
+
+    //AUTOGAIN makeup, its matched level is saved with the state
+    AutoGain autoGain;
+
+    //Levels and curve points for the editor
+    Telemetry telemetry;
+
+   #if QUADROUGH_PROFILING
+    //Recorded by the audio thread and the workers, see QUADROUGH_PROFILE_SCOPE
+    StageProfiler profiler;
+   #endif
+
+    //Idle detection, the whole block is skipped once the tails have decayed
+    SilenceDetector silence;
+    bool idle = false;
+
+    //Worst case tail of preTone + postTone over the TONE range, at the current samplerate
+    int filterTailSamples = 0;
+
+    std::atomic<double> tailSeconds { 0.0 };
+    std::atomic<juce::int64> skippedBlocks { 0 }, bypassedShaperBlocks { 0 }, dualMonoBlocks { 0 };
 
     //Samplerate used for initilialize filters
     float lastSampleRate;
@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    PluginState.cpp
+
+    Binary state of the parameters and the bank of factory presets.
+
+  ==============================================================================
+*/
+
+#include "PluginState.h"
+
+PluginState::PluginState(juce::AudioProcessor& processor, const juce::Identifier& stateType)
+    : type(stateType)
+{
+    for (auto* parameter : processor.getParameters()) {
+
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+        jassert(ranged != nullptr);
+
+        if (ranged != nullptr)
+            parameters.push_back(ranged);
+    }
+}
+
+PluginState::Values PluginState::capture() const
+{
+    Values values;
+    values.parameters.reserve(parameters.size());
+
+    for (auto* parameter : parameters)
+        values.parameters.push_back(parameter->convertFrom0to1(parameter->getValue()));
+
+    return values;
+}
+
+PluginState::Values PluginState::getDefaults() const
+{
+    Values values;
+    values.parameters.reserve(parameters.size());
+
+    for (auto* parameter : parameters)
+        values.parameters.push_back(parameter->convertFrom0to1(parameter->getDefaultValue()));
+
+    return values;
+}
+
+int PluginState::indexOf(const juce::String& parameterID) const noexcept
+{
+    for (size_t i = 0; i < parameters.size(); i++)
+        if (parameters[i]->paramID == parameterID)
+            return (int)i;
+
+    return -1;
+}
+
+void PluginState::write(const Values& values, juce::MemoryBlock& destData) const
+{
+    jassert(values.parameters.size() == parameters.size());
+
+    destData.reset();
+    juce::MemoryOutputStream stream(destData, false);
+
+    stream.writeInt(magic);
+    stream.writeShort((short)currentVersion);
+    stream.writeShort((short)parameters.size());
+
+    for (size_t i = 0; i < parameters.size(); i++) {
+
+        stream.writeString(parameters[i]->paramID);
+        stream.writeFloat(values.parameters[i]);
+    }
+
+    stream.writeBool(values.hasAutoGain);
+    stream.writeFloat(values.autoGainDb);
+}
+
+bool PluginState::isBinaryState(const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= 8 && (int)juce::ByteOrder::littleEndianInt(data) == magic;
+}
+
+bool PluginState::read(const void* data, int sizeInBytes, Values& values) const
+{
+    //Missing parameters take their default
+    values = getDefaults();
+
+    if (isBinaryState(data, sizeInBytes))
+        return readBinary(data, sizeInBytes, values);
+
+    //States of earlier versions: XML through copyXmlToBinary, or as text
+    if (auto xml = juce::AudioProcessor::getXmlFromBinary(data, sizeInBytes))
+        return readXml(*xml, values);
+
+    if (auto xml = juce::parseXML(juce::String::fromUTF8(static_cast<const char*>(data), sizeInBytes)))
+        return readXml(*xml, values);
+
+    return false;
+}
+
+bool PluginState::readBinary(const void* data, int sizeInBytes, Values& values) const
+{
+    juce::MemoryInputStream stream(data, (size_t)sizeInBytes, false);
+
+    stream.readInt();
+    const int version = stream.readShort();
+    const int numEntries = stream.readShort();
+
+    if (version < 1 || version > currentVersion || numEntries < 0)
+        return false;
+
+    for (int entry = 0; entry < numEntries; entry++) {
+
+        if (stream.isExhausted())
+            return false;
+
+        const auto parameterID = stream.readString();
+        const float value = stream.readFloat();
+        const int index = indexOf(parameterID);
+
+        if (index >= 0 && std::isfinite(value))
+            values.parameters[(size_t)index] = value;
+    }
+
+    if (stream.getNumBytesRemaining() < 5)
+        return false;
+
+    values.hasAutoGain = stream.readBool();
+    values.autoGainDb = stream.readFloat();
+
+    if (!std::isfinite(values.autoGainDb))
+        values.hasAutoGain = false;
+
+    return true;
+}
+
+bool PluginState::readXml(const juce::XmlElement& xml, Values& values) const
+{
+    if (!xml.hasTagName(type.toString()))
+        return false;
+
+    //One PARAM child per parameter, as written by the ValueTree of the AudioProcessorValueTreeState
+    for (auto* child = xml.getFirstChildElement(); child != nullptr; child = child->getNextElement()) {
+
+        const int index = indexOf(child->getStringAttribute("id"));
+
+        if (index >= 0 && child->hasAttribute("value"))
+            values.parameters[(size_t)index] = (float)child->getDoubleAttribute("value");
+    }
+
+    values.hasAutoGain = xml.hasAttribute("autoGainDb");
+    values.autoGainDb = (float)xml.getDoubleAttribute("autoGainDb");
+    return true;
+}
+
+void PluginState::apply(const Values& values) noexcept
+{
+    jassert(values.parameters.size() == parameters.size());
+
+    //Odd until every parameter is set
+    applyCount++;
+
+    for (size_t i = 0; i < juce::jmin(parameters.size(), values.parameters.size()); i++) {
+
+        auto* parameter = parameters[i];
+        const float value = parameter->convertTo0to1(values.parameters[i]);
+
+        //Hosts are only told about the parameters that change, each inside a change gesture
+        //like an edit on the interface
+        if (!juce::approximatelyEqual(value, parameter->getValue())) {
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost(value);
+            parameter->endChangeGesture();
+        }
+    }
+
+    applyCount++;
+}
+
+//==============================================================================
+namespace
+{
+    //Changes from the defaults, in the units of the parameters (dB, %, choice index, 0 / 1)
+    struct FactoryPreset
+    {
+        const char* name;
+        std::initializer_list<std::pair<const char*, float>> values;
+    };
+
+    const FactoryPreset factoryPresets[] = {
+        { "Init", {} },
+        { "Warm Bus", { { "DRIVE", 6.0f }, { "DRYWET", 60.0f }, { "TONE", -3.0f }, { "MIDSIDE", 1.0f }, { "CLIPPER", 1.0f } } },
+        { "Drum Crush", { { "DISTTYPE", 2.0f }, { "DRIVE", 14.0f }, { "DRYWET", 45.0f }, { "TONE", 4.0f }, { "CLIPPER", 1.0f },
+                          { "OVERSAMPLING", 2.0f }, { "QUALITY", 1.0f } } },
+        { "Tube Glue", { { "DISTTYPE", 1.0f }, { "DRIVE", 4.0f }, { "TONE", -2.0f }, { "AUTOGAIN", 1.0f } } },
+        { "Fold Lead", { { "DISTTYPE", 3.0f }, { "DRIVE", 10.0f }, { "DRYWET", 50.0f }, { "OVERSAMPLING", 2.0f }, { "QUALITY", 2.0f } } },
+        { "Multiband Master", { { "BANDS", 2.0f }, { "XOVER1", 150.0f }, { "XOVER2", 2500.0f }, { "DRIVE", 4.0f },
+                                { "BAND1DRIVE", -6.0f }, { "BAND2TYPE", 1.0f }, { "BAND3MIX", 40.0f },
+                                { "CLIPPER", 1.0f }, { "AUTOGAIN", 1.0f } } },
+    };
+}
+
+PresetBank::PresetBank(const PluginState& state)
+{
+    for (const auto& factory : factoryPresets) {
+
+        Preset preset { factory.name, state.getDefaults() };
+
+        for (const auto& value : factory.values) {
+
+            const int index = state.indexOf(value.first);
+
+            //Every ID must exist in createParameters
+            jassert(index >= 0);
+
+            if (index >= 0)
+                preset.values.parameters[(size_t)index] = value.second;
+        }
+
+        presets.push_back(std::move(preset));
+    }
+}
+
+void PresetBank::select(int index) noexcept
+{
+    if (index < 0 || index >= getNumPresets())
+        return;
+
+    current.store(index);
+    pending.store(index);
+}
+
+const PluginState::Values* PresetBank::takePending() noexcept
+{
+    const int index = pending.exchange(-1);
+    return index >= 0 ? &presets[(size_t)index].values : nullptr;
+}
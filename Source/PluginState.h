@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    PluginState.h
+
+    Binary state of the parameters and the bank of factory presets.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Reads and writes the values of every parameter.
+
+    The saved state is a small binary block: the magic "QRST", a format
+    version, the number of entries, then the ID and plain value of every
+    parameter and the matched level of the auto gain. It is a few hundred
+    bytes and reads without building an XML document or a ValueTree, so
+    recalling many instances costs next to nothing. The XML written by
+    earlier versions (copyXmlToBinary, or plain text) is still accepted.
+
+    Values are matched by ID, so states from other versions load: unknown IDs
+    are ignored and missing ones take their default.
+*/
+class PluginState
+{
+public:
+    //"QRST" read as a little endian int
+    static constexpr int magic = 0x54535251;
+
+    //Version written by this build, newer ones are rejected
+    static constexpr int currentVersion = 1;
+
+    //Plain value of every parameter, in the order of getParameters()
+    struct Values
+    {
+        std::vector<float> parameters;
+
+        //Matched level of AUTOGAIN, when the state has one
+        float autoGainDb = 0.0f;
+        bool hasAutoGain = false;
+    };
+
+    //Lists the parameters of the processor, which must all be RangedAudioParameters
+    PluginState(juce::AudioProcessor& processor, const juce::Identifier& stateType);
+
+    //Current value of every parameter
+    Values capture() const;
+
+    //Default value of every parameter
+    Values getDefaults() const;
+
+    //Index of the parameter in Values::parameters, -1 if the ID does not exist
+    int indexOf(const juce::String& parameterID) const noexcept;
+
+    void write(const Values& values, juce::MemoryBlock& destData) const;
+
+    //Binary state or XML. Returns false if the data is neither
+    bool read(const void* data, int sizeInBytes, Values& values) const;
+
+    //True if the data starts like a binary state of any version
+    static bool isBinaryState(const void* data, int sizeInBytes) noexcept;
+
+    //Sets every parameter that changes inside a change gesture, so the host is notified.
+    //The message thread, or any thread of an instance without a host
+    void apply(const Values& values) noexcept;
+
+    //Odd while apply() runs. Read before and after a snapshot of the parameters: a snapshot
+    //taken while it was odd or while it changed may hold a part of the values only
+    juce::uint32 getApplyCount() const noexcept { return applyCount.load(); }
+
+private:
+    bool readBinary(const void* data, int sizeInBytes, Values& values) const;
+    bool readXml(const juce::XmlElement& xml, Values& values) const;
+
+    std::vector<juce::RangedAudioParameter*> parameters;
+    juce::Identifier type;
+
+    std::atomic<juce::uint32> applyCount { 0 };
+};
+
+//==============================================================================
+/**
+    Factory presets, decoded once at construction.
+
+    select() can be called from any thread, including a host changing the
+    program from the audio thread: it only stores the index. The processor
+    takes the pending preset with takePending() on the message thread and
+    applies it there; blocks processed meanwhile keep their last values, see
+    PluginState::getApplyCount. The bank never changes after construction.
+*/
+class PresetBank
+{
+public:
+    explicit PresetBank(const PluginState& state);
+
+    int getNumPresets() const noexcept { return (int)presets.size(); }
+    const juce::String& getName(int index) const noexcept { return presets[(size_t)index].name; }
+
+    //Last preset selected
+    int getCurrent() const noexcept { return current.load(); }
+
+    //Any thread, lock free
+    void select(int index) noexcept;
+
+    //Message thread only (applyPendingPreset), never processBlock: applying a preset notifies the
+    //host. The values of the preset selected since the last call, or nullptr
+    const PluginState::Values* takePending() noexcept;
+
+private:
+    struct Preset
+    {
+        juce::String name;
+        PluginState::Values values;
+    };
+
+    std::vector<Preset> presets;
+    std::atomic<int> current { 0 }, pending { -1 };
+};
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    ShaperKernels.cpp
+
+    Vectorised block kernels for the four distortion algorithms.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ShaperKernels.h"
+#include "ShaperKernelsImpl.h"
+
+namespace ShaperKernels
+{
+   #if QUADROUGH_KERNELS_X86
+    //Defined in ShaperKernelsAVX2.cpp, compiled for AVX2 + FMA
+    const Table& getAVX2();
+   #endif
+
+    //==============================================================================
+    //Original per sample code, for float and double
+    template <typename SampleType>
+    static void classicScalar(SampleType* data, int numSamples, SampleType drive, SampleType drywet)
+    {
+        //Output compensation, constant over the block
+        SampleType compensation = std::tanh(4 / drive);
+
+        for (auto i = 0; i < numSamples; i++) {
+
+            data[i] = data[i] * (1 - drywet) + std::tanh(data[i] * drive) * compensation * drywet;
+        }
+    }
+
+    template <typename SampleType>
+    static void pristineScalar(SampleType* data, int numSamples, SampleType drive, SampleType drywet)
+    {
+        //Fixed parameters for distortion shapes
+        SampleType q = (SampleType)-0.05;
+        SampleType d = 7;
+        SampleType offset = q / (1 - std::exp(d * q));
+
+        for (auto i = 0; i < numSamples; i++) {
+
+            data[i] = data[i] * (1 - drywet) + ((data[i] * drive - q) / (1 - std::exp(-d * (data[i] * drive - q))) + offset) * drywet;
+        }
+    }
+
+    template <typename SampleType>
+    static void hardScalar(SampleType* data, int numSamples, SampleType drive, SampleType drywet)
+    {
+        //fixed threshold
+        SampleType threshold = 1;
+
+        for (auto i = 0; i < numSamples; i++) {
+
+            if (data[i] * drive > threshold) {
+                data[i] = data[i] * (1 - drywet) + threshold * drywet;
+            }
+            else if (data[i] * drive < -threshold) {
+                data[i] = data[i] * (1 - drywet) + (-threshold * drywet);
+            }
+            else {
+                data[i] = data[i] * (1 - drywet) + data[i] * drive * drywet;
+            }
+        }
+    }
+
+    template <typename SampleType>
+    static void madScalar(SampleType* data, int numSamples, SampleType drive, SampleType drywet)
+    {
+        //Factor to "speed" the distortion
+        SampleType factor = 4;
+
+        for (auto i = 0; i < numSamples; i++) {
+
+            data[i] = data[i] * (1 - drywet) + (data[i] + std::sin(factor * data[i] * drive)) * (SampleType)0.25 * drywet;
+        }
+    }
+
+    const Table& getScalar()
+    {
+        static const Table table { classicScalar<float>, pristineScalar<float>, hardScalar<float>, madScalar<float>, "scalar" };
+        return table;
+    }
+
+    const KernelTable<double>& getScalarDouble()
+    {
+        static const KernelTable<double> table { classicScalar<double>, pristineScalar<double>, hardScalar<double>, madScalar<double>, "scalar64" };
+        return table;
+    }
+
+    //==============================================================================
+    static const Table& getBaseline()
+    {
+       #if QUADROUGH_KERNELS_X86
+        static const Table table { blockKernel<SSE2Ops, ClassicShape>, blockKernel<SSE2Ops, PristineShape>,
+                                   blockKernel<SSE2Ops, HardShape>, blockKernel<SSE2Ops, MadShape>, "sse2" };
+       #elif QUADROUGH_KERNELS_NEON
+        static const Table table { blockKernel<NeonOps, ClassicShape>, blockKernel<NeonOps, PristineShape>,
+                                   blockKernel<NeonOps, HardShape>, blockKernel<NeonOps, MadShape>, "neon" };
+       #else
+        //No vector unit: the tables beat the scalar approximations of tanh and exp by about 2x,
+        //the clip and the sine are faster computed than looked up
+        static const Table table { getLookup().classic, getLookup().pristine,
+                                   blockKernel<ScalarOps, HardShape>, blockKernel<ScalarOps, MadShape>, "lookup" };
+       #endif
+        return table;
+    }
+
+    const Table& getBest()
+    {
+        static const Table& best = []() -> const Table&
+        {
+           #if QUADROUGH_KERNELS_X86
+            if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+                return getAVX2();
+           #endif
+            return getBaseline();
+        }();
+
+        return best;
+    }
+}
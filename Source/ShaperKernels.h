@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    ShaperKernels.h
+
+    Vectorised block kernels for the four distortion algorithms.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Block kernels for CLASSIC, PRISTINE, HARD and MAD.
+
+    Every kernel processes one channel in place, mixing the shaped signal with
+    the dry one:  out = in * (1 - drywet) + shape(in, drive) * drywet
+
+    The vector kernels replace std::tanh, exp and std::sin with range reduced
+    polynomial approximations and clamp without branches. The implementation
+    (SSE2, AVX2 + FMA or NEON) is picked once at runtime from the CPU
+    features. The scalar table keeps the original std:: maths, and is also
+    built in double precision for 64 bit hosts.
+*/
+namespace ShaperKernels
+{
+    template <typename SampleType>
+    struct KernelTable
+    {
+        //Processes numSamples samples of data in place
+        using Kernel = void (*)(SampleType* data, int numSamples, SampleType drive, SampleType drywet);
+
+        Kernel classic;
+        Kernel pristine;
+        Kernel hard;
+        Kernel mad;
+
+        //Name of the instruction set, for logs and benchmarks
+        const char* name;
+    };
+
+    using Table = KernelTable<float>;
+    using Kernel = Table::Kernel;
+
+    //Fastest implementation supported by this CPU
+    const Table& getBest();
+
+    //Original std:: maths, one sample at a time
+    const Table& getScalar();
+
+    //Same code in double precision, the shapers of the 64 bit processing
+    const KernelTable<double>& getScalarDouble();
+
+    //Interpolated lookup tables, constant cost whatever the curve (ShaperTables.cpp).
+    //Slower than the vector kernels: getBest() only takes its CLASSIC and PRISTINE on
+    //CPUs without SSE2 or NEON, where they are faster than the scalar approximations
+    const Table& getLookup();
+
+    //Maximum absolute error of the vector kernels against the exact curves (double
+    //precision), for inputs in [-4, 4] and drive in [0, 20] dB at 100% wet.
+    //PRISTINE is unbounded and reaches ~40 at full drive.
+    constexpr float classicMaxError = 5.0e-7f;
+    constexpr float pristineMaxError = 2.0e-5f;
+    constexpr float hardMaxError = 5.0e-8f;
+    constexpr float madMaxError = 2.5e-6f;
+
+    //Same for the lookup tables, relative for PRISTINE. MAD is limited by the float
+    //precision of drive * x, the argument of the sine
+    constexpr float lookupMaxError = 5.0e-6f;
+}
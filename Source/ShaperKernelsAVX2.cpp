@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    ShaperKernelsAVX2.cpp
+
+    AVX2 + FMA build of the shaper kernels. Only called after checking the CPU
+    features at runtime, see ShaperKernels::getBest().
+
+  ==============================================================================
+*/
+
+#include "ShaperKernels.h"
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+//Everything below is compiled for AVX2 + FMA, MSVC accepts the intrinsics without flags
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx2,fma")
+#endif
+
+#define QUADROUGH_KERNELS_AVX2 1
+#include "ShaperKernelsImpl.h"
+
+namespace ShaperKernels
+{
+    const Table& getAVX2()
+    {
+        static const Table table { blockKernel<AVX2Ops, ClassicShape>, blockKernel<AVX2Ops, PristineShape>,
+                                   blockKernel<AVX2Ops, HardShape>, blockKernel<AVX2Ops, MadShape>, "avx2" };
+        return table;
+    }
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+#endif
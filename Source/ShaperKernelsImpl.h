@@ -0,0 +1,331 @@
+/*
+  ==============================================================================
+
+    ShaperKernelsImpl.h
+
+    Instruction set wrappers and templated kernels shared by ShaperKernels.cpp
+    and ShaperKernelsAVX2.cpp. Only include it from those two files: each one
+    compiles the templates for its own instruction set, so everything here has
+    internal linkage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+ #define QUADROUGH_KERNELS_X86 1
+ #include <immintrin.h>
+#elif defined (__aarch64__) || defined (_M_ARM64)
+ #define QUADROUGH_KERNELS_NEON 1
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    //==============================================================================
+    //One float per lane, used for the tails and when there is no SIMD
+    struct ScalarOps
+    {
+        using V = float;
+        using M = bool;
+        static constexpr int width = 1;
+
+        static V load(const float* p) { return *p; }
+        static void store(float* p, V a) { *p = a; }
+        static V set(float x) { return x; }
+        static V add(V a, V b) { return a + b; }
+        static V sub(V a, V b) { return a - b; }
+        static V mul(V a, V b) { return a * b; }
+        static V div(V a, V b) { return a / b; }
+        static V madd(V a, V b, V c) { return a * b + c; }
+        static V min(V a, V b) { return b < a ? b : a; }
+        static V max(V a, V b) { return a < b ? b : a; }
+        static V abs(V a) { return std::abs(a); }
+        static V round(V a) { return std::nearbyint(a); }
+        static M lessThan(V a, V b) { return a < b; }
+        static V select(M m, V a, V b) { return m ? a : b; }
+
+        //2^n for an integral n in [-126, 127]
+        static V pow2i(V n)
+        {
+            int32_t bits = ((int32_t)n + 127) << 23;
+            float result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+    };
+
+   #if QUADROUGH_KERNELS_X86 && ! QUADROUGH_KERNELS_AVX2
+    //==============================================================================
+    struct SSE2Ops
+    {
+        using V = __m128;
+        using M = __m128;
+        static constexpr int width = 4;
+
+        static V load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, V a) { _mm_storeu_ps(p, a); }
+        static V set(float x) { return _mm_set1_ps(x); }
+        static V add(V a, V b) { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm_div_ps(a, b); }
+        static V madd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static V min(V a, V b) { return _mm_min_ps(a, b); }
+        static V max(V a, V b) { return _mm_max_ps(a, b); }
+        static V abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static V round(V a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+        static M lessThan(V a, V b) { return _mm_cmplt_ps(a, b); }
+        static V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+        static V pow2i(V n)
+        {
+            __m128i bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23);
+            return _mm_castsi128_ps(bits);
+        }
+    };
+   #endif
+
+   #if QUADROUGH_KERNELS_AVX2
+    //==============================================================================
+    struct AVX2Ops
+    {
+        using V = __m256;
+        using M = __m256;
+        static constexpr int width = 8;
+
+        static V load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, V a) { _mm256_storeu_ps(p, a); }
+        static V set(float x) { return _mm256_set1_ps(x); }
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V div(V a, V b) { return _mm256_div_ps(a, b); }
+        static V madd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+        static V min(V a, V b) { return _mm256_min_ps(a, b); }
+        static V max(V a, V b) { return _mm256_max_ps(a, b); }
+        static V abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static V round(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static M lessThan(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+
+        static V pow2i(V n)
+        {
+            __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+            return _mm256_castsi256_ps(bits);
+        }
+    };
+   #endif
+
+   #if QUADROUGH_KERNELS_NEON
+    //==============================================================================
+    struct NeonOps
+    {
+        using V = float32x4_t;
+        using M = uint32x4_t;
+        static constexpr int width = 4;
+
+        static V load(const float* p) { return vld1q_f32(p); }
+        static void store(float* p, V a) { vst1q_f32(p, a); }
+        static V set(float x) { return vdupq_n_f32(x); }
+        static V add(V a, V b) { return vaddq_f32(a, b); }
+        static V sub(V a, V b) { return vsubq_f32(a, b); }
+        static V mul(V a, V b) { return vmulq_f32(a, b); }
+        static V div(V a, V b) { return vdivq_f32(a, b); }
+        static V madd(V a, V b, V c) { return vfmaq_f32(c, a, b); }
+        static V min(V a, V b) { return vminq_f32(a, b); }
+        static V max(V a, V b) { return vmaxq_f32(a, b); }
+        static V abs(V a) { return vabsq_f32(a); }
+        static V round(V a) { return vrndnq_f32(a); }
+        static M lessThan(V a, V b) { return vcltq_f32(a, b); }
+        static V select(M m, V a, V b) { return vbslq_f32(m, a, b); }
+
+        static V pow2i(V n)
+        {
+            int32x4_t bits = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+            return vreinterpretq_f32_s32(bits);
+        }
+    };
+   #endif
+
+    //==============================================================================
+    //exp(a), Cody-Waite range reduction and a degree 6 polynomial (relative error ~1e-7)
+    template <typename O>
+    inline typename O::V approxExp(typename O::V a)
+    {
+        using V = typename O::V;
+
+        a = O::min(O::max(a, O::set(-87.0f)), O::set(88.0f));
+
+        V n = O::round(O::mul(a, O::set(1.44269504088896341f)));
+        V r = O::sub(a, O::mul(n, O::set(0.693359375f)));
+        r = O::sub(r, O::mul(n, O::set(-2.12194440e-4f)));
+
+        V p = O::set(1.9875691500e-4f);
+        p = O::madd(p, r, O::set(1.3981999507e-3f));
+        p = O::madd(p, r, O::set(8.3334519073e-3f));
+        p = O::madd(p, r, O::set(4.1665795894e-2f));
+        p = O::madd(p, r, O::set(1.6666665459e-1f));
+        p = O::madd(p, r, O::set(5.0000001201e-1f));
+        p = O::madd(p, O::mul(r, r), O::add(r, O::set(1.0f)));
+
+        return O::mul(p, O::pow2i(n));
+    }
+
+    //tanh(x) = sign(x) * (1 - e) / (1 + e) with e = exp(-2|x|), no cancellation for large |x|
+    template <typename O>
+    inline typename O::V approxTanh(typename O::V x)
+    {
+        using V = typename O::V;
+
+        V e = approxExp<O>(O::mul(O::abs(x), O::set(-2.0f)));
+        V t = O::div(O::sub(O::set(1.0f), e), O::add(O::set(1.0f), e));
+
+        return O::select(O::lessThan(x, O::set(0.0f)), O::sub(O::set(0.0f), t), t);
+    }
+
+    //sin(a), reduced to [-pi/2, pi/2] with a three part pi and an odd degree 11 polynomial
+    template <typename O>
+    inline typename O::V approxSin(typename O::V a)
+    {
+        using V = typename O::V;
+
+        a = O::min(O::max(a, O::set(-65536.0f)), O::set(65536.0f));
+
+        V k = O::round(O::mul(a, O::set(0.318309886183790672f)));
+        V r = O::sub(a, O::mul(k, O::set(3.140625f)));
+        r = O::sub(r, O::mul(k, O::set(9.67502593994140625e-4f)));
+        r = O::sub(r, O::mul(k, O::set(1.509957990978376432e-7f)));
+
+        //sin(r + k*pi) = (-1)^k sin(r)
+        V parity = O::abs(O::sub(k, O::mul(O::set(2.0f), O::round(O::mul(k, O::set(0.5f))))));
+        V sign = O::sub(O::set(1.0f), O::mul(O::set(2.0f), parity));
+
+        V r2 = O::mul(r, r);
+        V p = O::set(-2.5052108385441718775e-8f);
+        p = O::madd(p, r2, O::set(2.7557319223985890653e-6f));
+        p = O::madd(p, r2, O::set(-1.9841269841269841270e-4f));
+        p = O::madd(p, r2, O::set(8.3333333333333333333e-3f));
+        p = O::madd(p, r2, O::set(-1.6666666666666666667e-1f));
+        p = O::madd(O::mul(p, r2), r, r);
+
+        return O::mul(p, sign);
+    }
+
+    //==============================================================================
+    //Shaping curves, the per block constants are computed once in the constructor
+    template <typename O>
+    struct ClassicShape
+    {
+        //tanh(4 / drive) is the output compensation of the CLASSIC algorithm
+        explicit ClassicShape(float drivegain)
+            : drive(O::set(drivegain)), compensation(O::set(std::tanh(4.0f / drivegain))) {}
+
+        typename O::V operator()(typename O::V x) const
+        {
+            return O::mul(approxTanh<O>(O::mul(x, drive)), compensation);
+        }
+
+        typename O::V drive, compensation;
+    };
+
+    template <typename O>
+    struct PristineShape
+    {
+        //Triode curve: (v - q) / (1 - exp(-d (v - q))) + q / (1 - exp(d q)), with v = x * drive
+        explicit PristineShape(float drivegain)
+            : drive(O::set(drivegain)), offset(O::set(q / (1.0f - std::exp(d * q)))) {}
+
+        typename O::V operator()(typename O::V x) const
+        {
+            using V = typename O::V;
+
+            V v = O::sub(O::mul(x, drive), O::set(q));
+            V e = approxExp<O>(O::mul(v, O::set(-d)));
+            V y = O::div(v, O::sub(O::set(1.0f), e));
+
+            //0/0 at v == 0, the limit there is 1/d + v/2
+            V nearZero = O::madd(v, O::set(0.5f), O::set(1.0f / d));
+            y = O::select(O::lessThan(O::abs(v), O::set(1.0e-4f)), nearZero, y);
+
+            return O::add(y, offset);
+        }
+
+        static constexpr float q = -0.05f;
+        static constexpr float d = 7.0f;
+        typename O::V drive, offset;
+    };
+
+    template <typename O>
+    struct HardShape
+    {
+        explicit HardShape(float drivegain) : drive(O::set(drivegain)) {}
+
+        //Branchless clamp at the fixed threshold
+        typename O::V operator()(typename O::V x) const
+        {
+            return O::min(O::max(O::mul(x, drive), O::set(-1.0f)), O::set(1.0f));
+        }
+
+        typename O::V drive;
+    };
+
+    template <typename O>
+    struct MadShape
+    {
+        //Factor 4 "speeds" the distortion
+        explicit MadShape(float drivegain) : speed(O::set(4.0f * drivegain)) {}
+
+        //Sinusoidal foldover
+        typename O::V operator()(typename O::V x) const
+        {
+            return O::mul(O::add(x, approxSin<O>(O::mul(x, speed))), O::set(0.25f));
+        }
+
+        typename O::V speed;
+    };
+
+    //==============================================================================
+    //Vector body and scalar tail of the same approximation
+    template <typename O, template <typename> class Shape>
+    void blockKernel(float* data, int numSamples, float drive, float drywet)
+    {
+        using V = typename O::V;
+
+        const Shape<O> shape(drive);
+        const Shape<ScalarOps> tail(drive);
+
+        int i = 0;
+
+        //Fully wet, nothing to mix
+        if (drywet >= 1.0f) {
+
+            for (; i + O::width <= numSamples; i += O::width)
+                O::store(data + i, shape(O::load(data + i)));
+
+            for (; i < numSamples; i++)
+                data[i] = tail(data[i]);
+
+            return;
+        }
+
+        const V vDry = O::set(1.0f - drywet);
+        const V vWet = O::set(drywet);
+
+        for (; i + O::width <= numSamples; i += O::width) {
+
+            V x = O::load(data + i);
+            O::store(data + i, O::madd(x, vDry, O::mul(shape(x), vWet)));
+        }
+
+        for (; i < numSamples; i++) {
+
+            data[i] = data[i] * (1.0f - drywet) + tail(data[i]) * drywet;
+        }
+    }
+}
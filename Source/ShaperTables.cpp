@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    ShaperTables.cpp
+
+    Interpolated lookup tables of the distortion curves.
+
+  ==============================================================================
+*/
+
+#include "ShaperTables.h"
+#include "ShaperKernels.h"
+
+namespace
+{
+    //Fixed parameters for distortion shapes
+    const double q = -0.05;
+    const double d = 7.0;
+
+    //Factor to "speed" the MAD distortion
+    const double factor = 4.0;
+
+    //Triode curve of the PRISTINE algorithm without its offset, (v - q) / (1 - exp(-d (v - q)))
+    double triode(double v)
+    {
+        double w = v - q;
+
+        if (std::abs(w) < 1.0e-4)
+            return 1.0 / d + w * 0.5 + d * w * w / 12.0;
+
+        return w / (1.0 - std::exp(-d * w));
+    }
+
+    double triodeSlope(double v)
+    {
+        double w = v - q;
+
+        if (std::abs(w) < 1.0e-4)
+            return 0.5 + d * w / 6.0;
+
+        double e = std::exp(-d * w);
+        return (1.0 - e - w * d * e) / ((1.0 - e) * (1.0 - e));
+    }
+
+    //Every table is shared by all the instances in the process
+    struct Tables
+    {
+        //tanh is 1 in float above 9.1, 1 / 64 steps
+        ShaperLookupTable tanh { -9.5, 9.5, 1216, false,
+                                 [](double v) { return std::tanh(v); },
+                                 [](double v) { return 1.0 - std::tanh(v) * std::tanh(v); } };
+
+        //The triode is 0 below -8 and the line v - q above 8, 1 / 128 steps
+        ShaperLookupTable triode { -8.0, 8.0, 2048, false, ::triode, triodeSlope };
+
+        //One period of sin(factor * v)
+        ShaperLookupTable sine { 0.0, 2.0 * juce::MathConstants<double>::pi / factor, 256, true,
+                                 [](double v) { return std::sin(factor * v); },
+                                 [](double v) { return factor * std::cos(factor * v); } };
+
+        //Constant term of the triode curve, q / (1 - exp(d q))
+        float offset = (float)(q / (1.0 - std::exp(d * q)));
+    };
+
+    const Tables& getTables()
+    {
+        static const Tables tables;
+        return tables;
+    }
+
+    //==============================================================================
+    void classicLookup(float* data, int numSamples, float drive, float drywet)
+    {
+        const auto& tanh = getTables().tanh;
+        float compensation = std::tanh(4.0f / drive);
+
+        for (auto i = 0; i < numSamples; i++) {
+
+            data[i] = data[i] * (1 - drywet) + tanh(data[i] * drive) * compensation * drywet;
+        }
+    }
+
+    void pristineLookup(float* data, int numSamples, float drive, float drywet)
+    {
+        const auto& tables = getTables();
+
+        for (auto i = 0; i < numSamples; i++) {
+
+            data[i] = data[i] * (1 - drywet) + (tables.triode(data[i] * drive) + tables.offset) * drywet;
+        }
+    }
+
+    //The clip is already two comparisons, a table would only be slower
+    void hardLookup(float* data, int numSamples, float drive, float drywet)
+    {
+        for (auto i = 0; i < numSamples; i++) {
+
+            data[i] = data[i] * (1 - drywet) + juce::jlimit(-1.0f, 1.0f, data[i] * drive) * drywet;
+        }
+    }
+
+    void madLookup(float* data, int numSamples, float drive, float drywet)
+    {
+        const auto& sine = getTables().sine;
+
+        for (auto i = 0; i < numSamples; i++) {
+
+            data[i] = data[i] * (1 - drywet) + (data[i] + sine(data[i] * drive)) * 0.25f * drywet;
+        }
+    }
+}
+
+//==============================================================================
+const ShaperKernels::Table& ShaperKernels::getLookup()
+{
+    //Builds the tables on the first call, not on the audio thread
+    getTables();
+
+    static const Table table { classicLookup, pristineLookup, hardLookup, madLookup, "lookup" };
+    return table;
+}
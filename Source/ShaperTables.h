@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    ShaperTables.h
+
+    Interpolated lookup tables of the distortion curves.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Cubic Hermite table of a transfer curve f(v).
+
+    The table stores f and its exact derivative at every point, so it is
+    continuous with a continuous slope and the error is O(step^4). Outside
+    [minInput, maxInput] it extrapolates linearly from the end points, which
+    is exact for curves that saturate or become linear there, or it wraps
+    around when the curve is periodic.
+
+    Tables are functions of v = x * drive, so they do not depend on DRIVE.
+    They are built once and are read only afterwards.
+*/
+class ShaperLookupTable
+{
+public:
+    template <typename Function, typename Derivative>
+    ShaperLookupTable(double minimum, double maximum, int numIntervals, bool isPeriodic, Function f, Derivative df)
+        : minInput((float)minimum), maxInput((float)maximum),
+          step((maximum - minimum) / numIntervals), invStep((float)(numIntervals / (maximum - minimum))),
+          size(numIntervals), invSize(1.0f / (float)numIntervals), periodic(isPeriodic)
+    {
+        points.resize((size_t)numIntervals + 1);
+
+        for (int i = 0; i <= numIntervals; i++) {
+
+            double v = minimum + i * step;
+            points[(size_t)i] = { (float)f(v), (float)(df(v) * step) };
+        }
+    }
+
+    float operator()(float v) const noexcept
+    {
+        float position = (v - minInput) * invStep;
+
+        if (periodic) {
+            const float periods = position * invSize;
+
+            //From 2^23 periods on a float has no fractional part left, so the phase is lost anyway:
+            //those inputs, infinities and NaN read the start of the period instead of casting out of
+            //the range of int. Truncation rather than std::floor, which is a library call without SSE4.1
+            if (std::abs(periods) < 8388608.0f)
+                position -= (float)size * (float)(int)periods;
+            else
+                position = 0.0f;
+
+            if (position < 0.0f)
+                position += (float)size;
+        }
+        else if (position <= 0.0f) {
+            return points.front().value + (v - minInput) * points.front().tangent * invStep;
+        }
+        else if (!(position < (float)size)) {
+            //NaN lands here too and comes out as NaN, without an index
+            return points.back().value + (v - maxInput) * points.back().tangent * invStep;
+        }
+
+        int index = juce::jmin((int)position, size - 1);
+        float t = position - (float)index;
+
+        const auto& a = points[(size_t)index];
+        const auto& b = points[(size_t)index + 1];
+
+        //Hermite basis in Horner form
+        float delta = b.value - a.value;
+        float c2 = 3.0f * delta - 2.0f * a.tangent - b.tangent;
+        float c3 = a.tangent + b.tangent - 2.0f * delta;
+
+        return a.value + t * (a.tangent + t * (c2 + t * c3));
+    }
+
+private:
+    //Value and slope * step of each point, side by side for cache locality
+    struct Point
+    {
+        float value, tangent;
+    };
+
+    float minInput, maxInput;
+    double step;
+    float invStep;
+    int size;
+    float invSize;
+    bool periodic;
+    std::vector<Point> points;
+};
@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    SilenceDetector.cpp
+
+    Detects idle input, so the processor can skip blocks of silence.
+
+  ==============================================================================
+*/
+
+#include "SilenceDetector.h"
+
+template <typename SampleType>
+bool SilenceDetector::isIdle(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    const int numSamples = buffer.getNumSamples();
+
+    for (int channel = 0; channel < numChannels; channel++) {
+
+        //Any sound restarts the count
+        if (buffer.getMagnitude(channel, 0, numSamples) > threshold) {
+            silentSamples = 0;
+            return false;
+        }
+    }
+
+    //Silent for longer than the tail before this block
+    bool idle = silentSamples >= tailSamples;
+    silentSamples += numSamples;
+
+    return idle;
+}
+
+template bool SilenceDetector::isIdle(const juce::AudioBuffer<float>&, int) noexcept;
+template bool SilenceDetector::isIdle(const juce::AudioBuffer<double>&, int) noexcept;
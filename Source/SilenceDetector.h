@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    SilenceDetector.h
+
+    Detects idle input, so the processor can skip blocks of silence.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Tracks how long the input has been silent and tells when the output of
+    the whole chain is silent too.
+
+    Every block is scanned for its peak (FloatVectorOperations, SIMD). A block
+    is idle when its input is below the threshold and the input before it has
+    been below the threshold for longer than the tail of the chain, so the
+    filters, the oversampling and the shaper histories have already decayed.
+    Until then the chain runs normally: skipping only the shaper while the
+    filters ring would change the sound of the tails.
+*/
+class SilenceDetector
+{
+public:
+    //-120 dBFS, also the level the tails are measured down to
+    static constexpr float thresholdDb = -120.0f;
+
+    void reset() noexcept { silentSamples = 0; }
+
+    //Samples the chain needs to go quiet after the input stops
+    void setTailSamples(int numSamples) noexcept { tailSamples = numSamples; }
+    int getTailSamples() const noexcept { return tailSamples; }
+
+    //Scans the first numChannels channels, returns true if the output of this block is silent
+    template <typename SampleType>
+    bool isIdle(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+private:
+    //Set when the processor is built, the audio thread only reads it. The floor is below
+    //the default -100 dB of decibelsToGain, which would give 0
+    const float threshold = juce::Decibels::decibelsToGain(thresholdDb, thresholdDb - 1.0f);
+
+    juce::int64 silentSamples = 0;
+    int tailSamples = 0;
+};
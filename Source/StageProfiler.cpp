@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    StageProfiler.cpp
+
+    Optional timing of the processing stages, as histograms for the editor and the bench.
+
+  ==============================================================================
+*/
+
+#include "StageProfiler.h"
+
+#if QUADROUGH_PROFILING
+
+#include <chrono>
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+ #define QUADROUGH_PROFILING_RDTSC 1
+ #if defined (_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+static juce::int64 getSteadyNanoseconds() noexcept
+{
+    return (juce::int64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* StageProfiler::getStageName(int stage) noexcept
+{
+    static const char* const names[] = { "preFilters", "midSideEncode", "shaper", "midSideDecode", "postFilters", "ceiling", "block" };
+    return juce::isPositiveAndBelow(stage, (int)numStages) ? names[stage] : "";
+}
+
+StageProfiler::StageProfiler()
+{
+    //The first call measures the counter for a few milliseconds, never on the audio thread
+    getNanosecondsPerTick();
+    reset();
+}
+
+juce::int64 StageProfiler::now() noexcept
+{
+   #if QUADROUGH_PROFILING_RDTSC
+    return (juce::int64)__rdtsc();
+   #else
+    return getSteadyNanoseconds();
+   #endif
+}
+
+double StageProfiler::getNanosecondsPerTick() noexcept
+{
+   #if QUADROUGH_PROFILING_RDTSC
+    //Invariant TSC on every CPU of the last decade: a constant rate, whatever the frequency scaling
+    static const double nanosecondsPerTick = []
+    {
+        const auto startNanoseconds = getSteadyNanoseconds();
+        const auto startTicks = now();
+        juce::Thread::sleep(20);
+        const auto ticks = now() - startTicks;
+        const auto nanoseconds = getSteadyNanoseconds() - startNanoseconds;
+
+        return ticks > 0 ? (double)nanoseconds / (double)ticks : 1.0;
+    }();
+
+    return nanosecondsPerTick;
+   #else
+    return 1.0;
+   #endif
+}
+
+void StageProfiler::record(int stage, juce::int64 ticks) noexcept
+{
+    auto& histogram = histograms[(size_t)stage];
+    const auto nanoseconds = (juce::int64)((double)juce::jmax((juce::int64)0, ticks) * getNanosecondsPerTick());
+
+    histogram.bins[(size_t)getBin(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+
+    //Raised only by a longer duration, whichever thread gets there first
+    auto max = histogram.maxNanoseconds.load(std::memory_order_relaxed);
+
+    while (nanoseconds > max && !histogram.maxNanoseconds.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {}
+}
+
+void StageProfiler::reset() noexcept
+{
+    for (auto& histogram : histograms)
+    {
+        for (auto& bin : histogram.bins)
+            bin.store(0, std::memory_order_relaxed);
+
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.maxNanoseconds.store(0, std::memory_order_relaxed);
+    }
+}
+
+int StageProfiler::getBin(juce::int64 nanoseconds) noexcept
+{
+    //Everything below 16 ns in the first bin, everything above 67 ms in the last
+    const auto clamped = (juce::uint32)juce::jlimit((juce::int64)(1 << firstOctave), (juce::int64)(1 << (firstOctave + numOctaves)) - 1, nanoseconds);
+    const int octave = juce::findHighestSetBit(clamped);
+
+    //The two bits below the highest one pick the quarter of the octave
+    const int quarter = (int)(clamped >> (octave - 2)) & (binsPerOctave - 1);
+
+    return (octave - firstOctave) * binsPerOctave + quarter;
+}
+
+double StageProfiler::getBinEdge(int bin) noexcept
+{
+    const int octave = firstOctave + bin / binsPerOctave;
+    const int quarter = bin % binsPerOctave;
+
+    return std::ldexp(1.0 + (quarter + 1) / (double)binsPerOctave, octave);
+}
+
+StageProfiler::Summary StageProfiler::getSummary(int stage) const noexcept
+{
+    const auto& histogram = histograms[(size_t)stage];
+
+    //Counts copied first, the audio thread keeps recording
+    std::array<juce::uint32, numBins> bins;
+    juce::int64 total = 0;
+
+    for (int bin = 0; bin < numBins; bin++)
+    {
+        bins[(size_t)bin] = histogram.bins[(size_t)bin].load(std::memory_order_relaxed);
+        total += bins[(size_t)bin];
+    }
+
+    Summary summary;
+    summary.count = total;
+    summary.max = (double)histogram.maxNanoseconds.load(std::memory_order_relaxed) * 0.001;
+
+    if (total == 0)
+        return summary;
+
+    //First bin where the running count reaches the rank of the percentile
+    auto getPercentile = [&bins, total](double fraction)
+    {
+        const auto rank = juce::jmax((juce::int64)1, (juce::int64)std::ceil(fraction * (double)total));
+        juce::int64 running = 0;
+
+        for (int bin = 0; bin < numBins; bin++)
+        {
+            running += bins[(size_t)bin];
+
+            if (running >= rank)
+                return getBinEdge(bin) * 0.001;
+        }
+
+        return getBinEdge(numBins - 1) * 0.001;
+    };
+
+    //An upper edge above the exact max says less than the max itself
+    summary.p50 = juce::jmin(getPercentile(0.5), summary.max);
+    summary.p99 = juce::jmin(getPercentile(0.99), summary.max);
+
+    return summary;
+}
+
+juce::String StageProfiler::toJson() const
+{
+    juce::String json = "{";
+
+    for (int stage = 0; stage < numStages; stage++)
+    {
+        const auto summary = getSummary(stage);
+
+        json << (stage > 0 ? ", " : " ") << "\"" << getStageName(stage) << "\": { "
+             << "\"count\": " << juce::String(summary.count)
+             << ", \"p50Us\": " << juce::String(summary.p50, 3)
+             << ", \"p99Us\": " << juce::String(summary.p99, 3)
+             << ", \"maxUs\": " << juce::String(summary.max, 3) << " }";
+    }
+
+    return json + " }";
+}
+
+#endif
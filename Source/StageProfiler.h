@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    StageProfiler.h
+
+    Optional timing of the processing stages, as histograms for the editor and the bench.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Off unless the build turns it on: QUADROUGH_PROFILE_SCOPE then expands to nothing
+//and the processor has no profiler at all
+#ifndef QUADROUGH_PROFILING
+ #define QUADROUGH_PROFILING 0
+#endif
+
+#if QUADROUGH_PROFILING
+
+//==============================================================================
+/**
+    Time spent in every stage of the chain, per sub-block and per channel group.
+
+    A ScopeTimer reads the time stamp counter when it is built and when it goes
+    out of scope (RDTSC on x86, steady_clock elsewhere) and adds the difference
+    to the histogram of its stage. The histograms have four log spaced bins per
+    octave from 16 ns to 67 ms, plain relaxed atomic counters: the audio thread
+    and the workers of the channel groups record at the same time without a
+    lock, and any thread reads a summary whenever it wants. Percentiles are the
+    upper edge of their bin, within 19% of the exact value; the max is exact.
+*/
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        preFilters = 0,     //INPUT GAIN, safe filters and PRE filters, one fused pass
+        midSideEncode,
+        shaper,             //Oversampling, crossovers and shapers
+        midSideDecode,
+        postFilters,        //POST and safe filters, with the makeup and OUTPUT GAIN when CEILING is off
+        ceiling,            //True peak limiter and OUTPUT GAIN
+        block,              //A whole processBlock
+        numStages
+    };
+
+    static const char* getStageName(int stage) noexcept;
+
+    //Microseconds of a stage since the last reset
+    struct Summary
+    {
+        juce::int64 count = 0;
+        double p50 = 0.0, p99 = 0.0, max = 0.0;
+    };
+
+    //Calibrates the counter, off the audio thread
+    StageProfiler();
+
+    //Counter ticks, converted to time only when recorded
+    static juce::int64 now() noexcept;
+
+    //Any thread, lock free
+    void record(int stage, juce::int64 ticks) noexcept;
+
+    //Any thread, a record running at the same time may be partly cleared
+    void reset() noexcept;
+
+    Summary getSummary(int stage) const noexcept;
+
+    //Every stage as a JSON object, names to { count, p50Us, p99Us, maxUs }
+    juce::String toJson() const;
+
+    //Records the time between its construction and its destruction
+    class ScopeTimer
+    {
+    public:
+        ScopeTimer(StageProfiler& owner, int timedStage) noexcept
+            : profiler(owner), stage(timedStage), start(now())
+        {
+        }
+
+        ~ScopeTimer() noexcept { profiler.record(stage, now() - start); }
+
+    private:
+        StageProfiler& profiler;
+        const int stage;
+        const juce::int64 start;
+    };
+
+private:
+    static constexpr int binsPerOctave = 4;
+    static constexpr int firstOctave = 4;
+    static constexpr int numOctaves = 22;
+    static constexpr int numBins = binsPerOctave * numOctaves;
+
+    struct Histogram
+    {
+        std::array<std::atomic<juce::uint32>, numBins> bins;
+        std::atomic<juce::int64> count { 0 }, maxNanoseconds { 0 };
+    };
+
+    //Bin of a duration, and the upper edge of a bin
+    static int getBin(juce::int64 nanoseconds) noexcept;
+    static double getBinEdge(int bin) noexcept;
+
+    //Measured once, against steady_clock
+    static double getNanosecondsPerTick() noexcept;
+
+    std::array<Histogram, numStages> histograms;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StageProfiler)
+};
+
+ #define QUADROUGH_PROFILE_SCOPE(profiler, stage) \
+    const StageProfiler::ScopeTimer JUCE_JOIN_MACRO(profileScope, __LINE__) ((profiler), StageProfiler::stage)
+
+#else
+
+ #define QUADROUGH_PROFILE_SCOPE(profiler, stage)
+
+#endif
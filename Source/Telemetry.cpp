@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    Telemetry.cpp
+
+    Levels and transfer curve points from the audio thread to the editor.
+
+  ==============================================================================
+*/
+
+#include "Telemetry.h"
+#include "AutoGain.h"
+
+void Telemetry::prepare(double sampleRate) noexcept
+{
+    samplesPerFrame = juce::jmax(1, juce::roundToInt(sampleRate * frameSeconds));
+
+    current = Levels();
+    inputSum = outputSum = 0.0;
+    inputCount = outputCount = 0;
+    frameSamples = 0;
+}
+
+template <typename SampleType>
+void Telemetry::measure(const juce::AudioBuffer<SampleType>& buffer, int numChannels, float& peak, double& sumOfSquares) noexcept
+{
+    const int numSamples = buffer.getNumSamples();
+
+    for (int channel = 0; channel < juce::jmin(numChannels, buffer.getNumChannels()); channel++) {
+
+        peak = juce::jmax(peak, (float)buffer.getMagnitude(channel, 0, numSamples));
+        sumOfSquares += AutoGain::getSumOfSquares(buffer.getReadPointer(channel), numSamples);
+    }
+}
+
+template <typename SampleType>
+void Telemetry::beginBlock(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    measure(buffer, numChannels, current.inputPeak, inputSum);
+    inputCount += juce::jmin(numChannels, buffer.getNumChannels()) * buffer.getNumSamples();
+}
+
+template <typename SampleType>
+void Telemetry::endBlock(const juce::AudioBuffer<SampleType>& buffer, int numChannels, float ceilingGain) noexcept
+{
+    measure(buffer, numChannels, current.outputPeak, outputSum);
+    outputCount += juce::jmin(numChannels, buffer.getNumChannels()) * buffer.getNumSamples();
+    current.ceilingGain = juce::jmin(current.ceilingGain, ceilingGain);
+
+    frameSamples += buffer.getNumSamples();
+
+    if (frameSamples < samplesPerFrame)
+        return;
+
+    //Square roots once per frame
+    current.inputRms = inputCount > 0 ? (float)std::sqrt(inputSum / inputCount) : 0.0f;
+    current.outputRms = outputCount > 0 ? (float)std::sqrt(outputSum / outputCount) : 0.0f;
+
+    //A full ring means the editor is not reading, the frame is lost
+    levelFrames.push(current);
+
+    current = Levels();
+    inputSum = outputSum = 0.0;
+    inputCount = outputCount = 0;
+    frameSamples = 0;
+}
+
+template void Telemetry::beginBlock(const juce::AudioBuffer<float>&, int) noexcept;
+template void Telemetry::beginBlock(const juce::AudioBuffer<double>&, int) noexcept;
+template void Telemetry::endBlock(const juce::AudioBuffer<float>&, int, float) noexcept;
+template void Telemetry::endBlock(const juce::AudioBuffer<double>&, int, float) noexcept;
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    Telemetry.h
+
+    Levels and transfer curve points from the audio thread to the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Single producer, single consumer ring of fixed capacity.
+
+    The storage is allocated with the object; push and pop only move the
+    atomic indices of juce::AbstractFifo, so neither side ever locks, waits or
+    allocates. When the ring is full the new item is dropped.
+*/
+template <typename Item, int capacity>
+class TelemetryFifo
+{
+public:
+    //Audio thread. Returns false if the ring is full
+    bool push(const Item& item) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        items[(size_t)(size1 > 0 ? start1 : start2)] = item;
+        fifo.finishedWrite(1);
+        return true;
+    }
+
+    //Editor thread. Returns false if the ring is empty
+    bool pop(Item& item) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        item = items[(size_t)(size1 > 0 ? start1 : start2)];
+        fifo.finishedRead(1);
+        return true;
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<Item, (size_t)capacity> items {};
+};
+
+//==============================================================================
+/**
+    Metering and scope data published by processBlock for the editor.
+
+    Every frameSeconds the audio thread pushes one Levels frame (peak and RMS
+    of the input and output, and the largest ceiling gain reduction), and the
+    shaper pushes one input/output pair per sub-block for the transfer curve
+    scatter. All of it is skipped while no editor is open: the editor calls
+    setActive, and the processor checks isActive once per block.
+*/
+class Telemetry
+{
+public:
+    //Frame rate of the levels, faster than any editor refresh
+    static constexpr double frameSeconds = 1.0 / 120.0;
+
+    struct Levels
+    {
+        float inputPeak = 0.0f, inputRms = 0.0f;
+        float outputPeak = 0.0f, outputRms = 0.0f;
+
+        //Lowest gain of the ceiling limiter, 1 when it did not limit
+        float ceilingGain = 1.0f;
+    };
+
+    struct CurvePoint
+    {
+        float input = 0.0f, output = 0.0f;
+    };
+
+    //Editor thread, on open and close
+    void setActive(bool shouldBeActive) noexcept { active.store(shouldBeActive); }
+    bool isActive() const noexcept { return active.load(std::memory_order_relaxed); }
+
+    //Audio thread
+    void prepare(double sampleRate) noexcept;
+
+    //Audio thread: the unprocessed input, at the start of processBlock
+    template <typename SampleType>
+    void beginBlock(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+    //Audio thread: the output at the end of processBlock, with the lowest gain of the ceiling in the block
+    template <typename SampleType>
+    void endBlock(const juce::AudioBuffer<SampleType>& buffer, int numChannels, float ceilingGain) noexcept;
+
+    //Audio thread: one point of the shaper curve
+    void addCurvePoint(float input, float output) noexcept { curvePoints.push({ input, output }); }
+
+    //Editor thread
+    bool popLevels(Levels& levels) noexcept { return levelFrames.pop(levels); }
+    bool popCurvePoint(CurvePoint& point) noexcept { return curvePoints.pop(point); }
+
+private:
+    //Largest magnitude and sum of squares of the first numChannels channels
+    template <typename SampleType>
+    static void measure(const juce::AudioBuffer<SampleType>& buffer, int numChannels, float& peak, double& sumOfSquares) noexcept;
+
+    TelemetryFifo<Levels, 64> levelFrames;
+    TelemetryFifo<CurvePoint, 2048> curvePoints;
+
+    std::atomic<bool> active { false };
+
+    //Frame being accumulated, audio thread only
+    Levels current;
+    double inputSum = 0.0, outputSum = 0.0;
+    int inputCount = 0, outputCount = 0;
+    int frameSamples = 0, samplesPerFrame = 400;
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    ToneFilters.cpp
+
+    Coefficient manager for the PRE/POST tone filters and the safety filters.
+
+  ==============================================================================
+*/
+
+#include "ToneFilters.h"
+
+void ToneCoefficientManager::prepare(double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    needsUpdate = true;
+}
+
+bool ToneCoefficientManager::update(float tonedb)
+{
+    if (!needsUpdate && juce::approximatelyEqual(tonedb, currentTone))
+        return false;
+
+    auto& pre = coefficients.pre;
+    auto& post = coefficients.post;
+
+    //The safety filters only depend on the samplerate
+    if (needsUpdate) {
+
+        lowShelfAngle = makeAngle(currentSampleRate, 144.0);
+        highShelfAngle = makeAngle(currentSampleRate, 2773.0);
+        midBellAngle = makeAngle(currentSampleRate, 755.0);
+
+        makeLowPass(pre[lowPass], currentSampleRate, 22000.0, 0.1);
+        makeHighPass(pre[highPass], currentSampleRate, 18.0, 0.1);
+        post[lowPass] = pre[lowPass];
+        post[highPass] = pre[highPass];
+    }
+
+    currentTone = tonedb;
+    needsUpdate = false;
+
+    double postone = juce::Decibels::decibelsToGain((double)tonedb);
+    double negtone = 1.0 / postone;
+
+    //Prefilters, no trigonometry needed while TONE moves
+    makeLowShelf(pre[lowShelf], lowShelfAngle, 0.5, postone);
+    makeHighShelf(pre[highShelf], highShelfAngle, 0.5, postone);
+    makePeakFilter(pre[midBell], midBellAngle, 1.0, negtone);
+
+    //Postfilters
+    makeLowShelf(post[lowShelf], lowShelfAngle, 0.5, negtone);
+    makeHighShelf(post[highShelf], highShelfAngle, 0.5, negtone);
+    makePeakFilter(post[midBell], midBellAngle, 1.0, postone);
+
+    return true;
+}
+
+void ToneCoefficientManager::normalise(Biquad& biquad, double b0, double b1, double b2, double a0, double a1, double a2) noexcept
+{
+    double a0inv = 1.0 / a0;
+
+    biquad[0] = b0 * a0inv;
+    biquad[1] = b1 * a0inv;
+    biquad[2] = b2 * a0inv;
+    biquad[3] = a1 * a0inv;
+    biquad[4] = a2 * a0inv;
+}
+
+void ToneCoefficientManager::makeLowPass(Biquad& biquad, double sampleRate, double frequency, double Q) noexcept
+{
+    double n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    double nSquared = n * n;
+    double invQ = 1.0 / Q;
+    double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    normalise(biquad, c1, c1 * 2.0, c1,
+              1.0, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared));
+}
+
+void ToneCoefficientManager::makeHighPass(Biquad& biquad, double sampleRate, double frequency, double Q) noexcept
+{
+    double n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    double nSquared = n * n;
+    double invQ = 1.0 / Q;
+    double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+    normalise(biquad, c1, c1 * -2.0, c1,
+              1.0, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - invQ * n + nSquared));
+}
+
+ToneCoefficientManager::Angle ToneCoefficientManager::makeAngle(double sampleRate, double frequency) noexcept
+{
+    double omega = (2.0 * juce::MathConstants<double>::pi * juce::jmax(frequency, 2.0)) / sampleRate;
+    return { std::cos(omega), std::sin(omega) };
+}
+
+void ToneCoefficientManager::makeLowShelf(Biquad& biquad, double sampleRate, double frequency, double Q, double gainFactor) noexcept
+{
+    makeLowShelf(biquad, makeAngle(sampleRate, frequency), Q, gainFactor);
+}
+
+void ToneCoefficientManager::makeHighShelf(Biquad& biquad, double sampleRate, double frequency, double Q, double gainFactor) noexcept
+{
+    makeHighShelf(biquad, makeAngle(sampleRate, frequency), Q, gainFactor);
+}
+
+void ToneCoefficientManager::makePeakFilter(Biquad& biquad, double sampleRate, double frequency, double Q, double gainFactor) noexcept
+{
+    makePeakFilter(biquad, makeAngle(sampleRate, frequency), Q, gainFactor);
+}
+
+void ToneCoefficientManager::makeLowShelf(Biquad& biquad, const Angle& angle, double Q, double gainFactor) noexcept
+{
+    double A = juce::jmax(0.0, std::sqrt(gainFactor));
+    double aminus1 = A - 1.0;
+    double aplus1 = A + 1.0;
+    double coso = angle.cos;
+    double beta = angle.sin * std::sqrt(A) / Q;
+    double aminus1TimesCoso = aminus1 * coso;
+
+    normalise(biquad, A * (aplus1 - aminus1TimesCoso + beta),
+              A * 2.0 * (aminus1 - aplus1 * coso),
+              A * (aplus1 - aminus1TimesCoso - beta),
+              aplus1 + aminus1TimesCoso + beta,
+              -2.0 * (aminus1 + aplus1 * coso),
+              aplus1 + aminus1TimesCoso - beta);
+}
+
+void ToneCoefficientManager::makeHighShelf(Biquad& biquad, const Angle& angle, double Q, double gainFactor) noexcept
+{
+    double A = juce::jmax(0.0, std::sqrt(gainFactor));
+    double aminus1 = A - 1.0;
+    double aplus1 = A + 1.0;
+    double coso = angle.cos;
+    double beta = angle.sin * std::sqrt(A) / Q;
+    double aminus1TimesCoso = aminus1 * coso;
+
+    normalise(biquad, A * (aplus1 + aminus1TimesCoso + beta),
+              A * -2.0 * (aminus1 + aplus1 * coso),
+              A * (aplus1 + aminus1TimesCoso - beta),
+              aplus1 - aminus1TimesCoso + beta,
+              2.0 * (aminus1 - aplus1 * coso),
+              aplus1 - aminus1TimesCoso - beta);
+}
+
+void ToneCoefficientManager::makePeakFilter(Biquad& biquad, const Angle& angle, double Q, double gainFactor) noexcept
+{
+    double A = juce::jmax(0.0, std::sqrt(gainFactor));
+    double alpha = angle.sin / (Q * 2.0);
+    double c2 = -2.0 * angle.cos;
+    double alphaTimesA = alpha * A;
+    double alphaOverA = alpha / A;
+
+    normalise(biquad, 1.0 + alphaTimesA, c2, 1.0 - alphaTimesA,
+              1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    ToneFilters.h
+
+    Coefficient manager for the PRE/POST tone filters and the safety filters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Holds the biquads of the ten tone/safety filters and recomputes them in
+    place, only when TONE or the sample rate change.
+
+    The designs are the same RBJ formulas used by juce::dsp::IIR::Coefficients,
+    stored with the same normalisation (b0, b1, b2, a1, a2 with a0 == 1), and
+    are read by the ToneStage cascades without allocating on the audio thread.
+    The processor owns one and designs each sub-block once, for every group.
+*/
+class ToneCoefficientManager
+{
+public:
+    //Sections of each stage (PRE and POST have the same five filters)
+    enum Section
+    {
+        lowPass = 0,
+        highPass,
+        lowShelf,
+        highShelf,
+        midBell,
+        numSections
+    };
+
+    //Normalised biquad, in double precision: each ToneStage rounds it to its sample type
+    using Biquad = std::array<double, 5>;
+
+    //Every section of both stages, what the channel groups copy into their cascades
+    struct Coefficients
+    {
+        std::array<Biquad, numSections> pre{}, post{};
+    };
+
+    //Forces a full recompute on the next update
+    void prepare(double sampleRate);
+
+    //Recomputes the coefficients if TONE or the sample rate changed, returns true if it did
+    bool update(float tonedb);
+
+    const Coefficients& getCoefficients() const noexcept { return coefficients; }
+    const Biquad& getPre(Section section) const noexcept { return coefficients.pre[(size_t)section]; }
+    const Biquad& getPost(Section section) const noexcept { return coefficients.post[(size_t)section]; }
+
+    //In place filter designs
+    static void makeLowPass(Biquad&, double sampleRate, double frequency, double Q) noexcept;
+    static void makeHighPass(Biquad&, double sampleRate, double frequency, double Q) noexcept;
+    static void makeLowShelf(Biquad&, double sampleRate, double frequency, double Q, double gainFactor) noexcept;
+    static void makeHighShelf(Biquad&, double sampleRate, double frequency, double Q, double gainFactor) noexcept;
+    static void makePeakFilter(Biquad&, double sampleRate, double frequency, double Q, double gainFactor) noexcept;
+
+private:
+    //cos and sin of a centre frequency, they only change with the samplerate
+    struct Angle
+    {
+        double cos = 1.0, sin = 0.0;
+    };
+
+    static Angle makeAngle(double sampleRate, double frequency) noexcept;
+    static void makeLowShelf(Biquad&, const Angle&, double Q, double gainFactor) noexcept;
+    static void makeHighShelf(Biquad&, const Angle&, double Q, double gainFactor) noexcept;
+    static void makePeakFilter(Biquad&, const Angle&, double Q, double gainFactor) noexcept;
+
+    static void normalise(Biquad&, double b0, double b1, double b2, double a0, double a1, double a2) noexcept;
+
+    Coefficients coefficients;
+    Angle lowShelfAngle, highShelfAngle, midBellAngle;
+
+    double currentSampleRate = 44100.0;
+    float currentTone = 0.0f;
+    bool needsUpdate = true;
+};
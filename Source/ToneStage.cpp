@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    ToneStage.cpp
+
+    Fused cascade of the five tone/safety biquads of PRE or POST.
+
+  ==============================================================================
+*/
+
+#include "ToneStage.h"
+
+template <typename SampleType>
+void ToneStage<SampleType>::prepare(int numChannels)
+{
+    states.assign((size_t)juce::jmax(1, numChannels), ChannelState());
+}
+
+template <typename SampleType>
+void ToneStage<SampleType>::reset() noexcept
+{
+    std::fill(states.begin(), states.end(), ChannelState());
+}
+
+template <typename SampleType>
+int ToneStage<SampleType>::getTailSamples(double attenuationDb, int maximumSamples) const noexcept
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    const double threshold = std::pow(10.0, -std::abs(attenuationDb) / 20.0);
+
+    //Impulse response in double precision, same TDF-II sections
+    std::array<std::array<double, 2>, numSections> sectionStates{};
+    int lastAbove = 0;
+
+    for (int n = 0; n < maximumSamples; n++)
+    {
+        double x = n == 0 ? 1.0 : 0.0;
+
+        for (size_t section = 0; section < (size_t)numSections; section++)
+        {
+            auto& c = coefficients[section];
+            auto& state = sectionStates[section];
+
+            double y = c[0] * x + state[0];
+            state[0] = c[1] * x - c[3] * y + state[1];
+            state[1] = c[2] * x - c[4] * y;
+            x = y;
+        }
+
+        if (std::abs(x) > threshold) {
+            lastAbove = n;
+        }
+        else if (n - lastAbove > juce::jmax(256, lastAbove)) {
+            //Quiet for as long as it rang, only the slowest modes are left and they keep decaying
+            break;
+        }
+    }
+
+    return lastAbove + 1;
+}
+
+template <typename SampleType>
+void ToneStage<SampleType>::setCoefficients(int position, const Biquad& biquad) noexcept
+{
+    for (size_t i = 0; i < biquad.size(); i++)
+        coefficients[(size_t)position][i] = (SampleType)biquad[i];
+}
+
+template <typename SampleType>
+void ToneStage<SampleType>::process(Block& block) noexcept
+{
+    processChannels<noGain>(block, 1, 1);
+}
+
+template <typename SampleType>
+void ToneStage<SampleType>::processWithInputGain(Block& block, float gainStart, float gainEnd) noexcept
+{
+    processChannels<inputGain>(block, gainStart, gainEnd);
+}
+
+template <typename SampleType>
+void ToneStage<SampleType>::processWithOutputGain(Block& block, float gainStart, float gainEnd) noexcept
+{
+    processChannels<outputGain>(block, gainStart, gainEnd);
+}
+
+template <typename SampleType>
+template <typename ToneStage<SampleType>::GainMode mode>
+void ToneStage<SampleType>::processChannels(Block& block, SampleType gainStart, SampleType gainEnd) noexcept
+{
+    jassert(block.getNumChannels() <= states.size());
+
+    const size_t numChannels = juce::jmin(block.getNumChannels(), states.size());
+    const size_t numSamples = block.getNumSamples();
+    const SampleType gainIncrement = numSamples > 0 ? (gainEnd - gainStart) / (SampleType)numSamples : 0;
+    size_t channel = 0;
+
+    //Pairs of channels share the frame loop, the odd one out runs alone
+    for (; channel + 1 < numChannels; channel += 2) {
+
+        SampleType* channels[] = { block.getChannelPointer(channel), block.getChannelPointer(channel + 1) };
+        processFrames<2, mode>(channels, &states[channel], numSamples, gainStart, gainIncrement);
+    }
+
+    if (channel < numChannels) {
+
+        SampleType* channels[] = { block.getChannelPointer(channel) };
+        processFrames<1, mode>(channels, &states[channel], numSamples, gainStart, gainIncrement);
+    }
+}
+
+template <typename SampleType>
+template <int numChannels, typename ToneStage<SampleType>::GainMode mode>
+void ToneStage<SampleType>::processFrames(SampleType* const* channels, ChannelState* channelStates, size_t numSamples, SampleType gainStart, SampleType gainIncrement) noexcept
+{
+    //Local copies, so the compiler can keep everything in registers
+    const auto c = coefficients;
+    ChannelState s[(size_t)numChannels];
+
+    for (int ch = 0; ch < numChannels; ch++)
+        s[ch] = channelStates[ch];
+
+    for (size_t i = 0; i < numSamples; i++) {
+
+        const SampleType gain = gainStart + gainIncrement * (SampleType)i;
+
+        for (int ch = 0; ch < numChannels; ch++) {
+
+            SampleType sample = channels[ch][i];
+
+            if (mode == inputGain)
+                sample *= gain;
+
+            for (int n = 0; n < numSections; n++) {
+
+                const auto& b = c[(size_t)n];
+                auto& state = s[ch][(size_t)n];
+
+                //Same order of operations as juce::dsp::IIR::Filter
+                SampleType output = (b[0] * sample) + state.s1;
+                state.s1 = (b[1] * sample) - (b[3] * output) + state.s2;
+                state.s2 = (b[2] * sample) - (b[4] * output);
+                sample = output;
+            }
+
+            if (mode == outputGain)
+                sample *= gain;
+
+            channels[ch][i] = sample;
+        }
+    }
+
+    //Denormals are flushed at the end of the block, like the JUCE filters do
+    for (int ch = 0; ch < numChannels; ch++) {
+
+        for (auto& state : s[ch]) {
+
+            juce::dsp::util::snapToZero(state.s1);
+            juce::dsp::util::snapToZero(state.s2);
+        }
+
+        channelStates[ch] = s[ch];
+    }
+}
+
+template class ToneStage<float>;
+template class ToneStage<double>;
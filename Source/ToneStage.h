@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    ToneStage.h
+
+    Fused cascade of the five tone/safety biquads of PRE or POST.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ToneFilters.h"
+
+//==============================================================================
+/**
+    Runs the five biquads of a tone stage in one pass over the block.
+
+    Every section is a transposed direct form II, the same structure and
+    operation order as juce::dsp::IIR::Filter, so the output matches five
+    separate filters to the last bit as long as the compiler does not
+    contract to FMA. The sample goes through all the sections while it is in
+    a register, and a stereo block runs both channels in the same frame
+    loop, so the two independent chains overlap in the pipeline. The gain
+    stages around the filters can be fused in the same pass.
+
+    The sample type is float or double (64 bit hosts), with the coefficients
+    and the states in the same precision. Both are instantiated in
+    ToneStage.cpp.
+*/
+template <typename SampleType>
+class ToneStage
+{
+public:
+    static constexpr int numSections = ToneCoefficientManager::numSections;
+    using Biquad = ToneCoefficientManager::Biquad;
+    using Block = juce::dsp::AudioBlock<SampleType>;
+
+    //Allocates the state of every channel
+    void prepare(int numChannels);
+    void reset() noexcept;
+
+    //Gives the destination channel the history of the source, after processing only the source
+    void copyChannelState(int source, int destination) noexcept { states[(size_t)destination] = states[(size_t)source]; }
+
+    //Sets the section at the given position of the cascade (processing order), rounded to the sample type
+    void setCoefficients(int position, const Biquad& biquad) noexcept;
+
+    //Length of the impulse response of the cascade until it stays below -attenuationDb, in
+    //samples. Measured by running the cascade, a few milliseconds: call it when preparing
+    int getTailSamples(double attenuationDb, int maximumSamples) const noexcept;
+
+    void process(Block& block) noexcept;
+
+    //Same pass with a linear gain ramp applied to the input of the cascade
+    void processWithInputGain(Block& block, float gainStart, float gainEnd) noexcept;
+
+    //Same pass with a linear gain ramp applied to the output of the cascade
+    void processWithOutputGain(Block& block, float gainStart, float gainEnd) noexcept;
+
+private:
+    //Where the fused gain ramp goes
+    enum GainMode
+    {
+        noGain = 0,
+        inputGain,
+        outputGain
+    };
+
+    //TDF-II state of one section
+    struct SectionState
+    {
+        SampleType s1 = 0, s2 = 0;
+    };
+
+    using ChannelState = std::array<SectionState, numSections>;
+
+    template <GainMode mode>
+    void processChannels(Block& block, SampleType gainStart, SampleType gainEnd) noexcept;
+
+    template <int numChannels, GainMode mode>
+    void processFrames(SampleType* const* channels, ChannelState* states, size_t numSamples, SampleType gainStart, SampleType gainIncrement) noexcept;
+
+    std::array<std::array<SampleType, 5>, numSections> coefficients{};
+    std::vector<ChannelState> states;
+
+    JUCE_LEAK_DETECTOR(ToneStage)
+};
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    WorkerPool.cpp
+
+    A few threads that run the channel groups of a block next to the audio thread.
+
+  ==============================================================================
+*/
+
+#include "WorkerPool.h"
+
+#include <thread>
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+//Counting semaphore of the system. post() is an atomic increment, with a system call only
+//when a worker sleeps on it, and never takes a lock in user space
+class WorkerPool::Semaphore
+{
+public:
+   #if JUCE_WINDOWS
+    Semaphore() : handle(CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr)) {}
+    ~Semaphore() { CloseHandle(handle); }
+
+    void post() noexcept { ReleaseSemaphore(handle, 1, nullptr); }
+    void wait() noexcept { WaitForSingleObject(handle, INFINITE); }
+
+private:
+    HANDLE handle;
+   #elif JUCE_MAC || JUCE_IOS
+    Semaphore() : semaphore(dispatch_semaphore_create(0)) {}
+    ~Semaphore() { dispatch_release(semaphore); }
+
+    void post() noexcept { dispatch_semaphore_signal(semaphore); }
+    void wait() noexcept { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+
+private:
+    dispatch_semaphore_t semaphore;
+   #else
+    Semaphore() { sem_init(&semaphore, 0, 0); }
+    ~Semaphore() { sem_destroy(&semaphore); }
+
+    void post() noexcept { sem_post(&semaphore); }
+
+    void wait() noexcept
+    {
+        while (sem_wait(&semaphore) != 0 && errno == EINTR) {}
+    }
+
+private:
+    sem_t semaphore;
+   #endif
+};
+
+//One thread, asleep on the semaphore between two runs
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker(WorkerPool& owner, int index)
+        : juce::Thread("QuadRough worker " + juce::String(index)), pool(owner)
+    {
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit()) {
+
+            pool.wake->wait();
+
+            if (threadShouldExit())
+                break;
+
+            pool.work();
+        }
+    }
+
+private:
+    WorkerPool& pool;
+};
+
+//Audio priority with the API of the JUCE version: 7.0.6 replaced the priority numbers with
+//realtime options, 6.1 added realtimeAudioPriority, 6.0 only has the numbers up to 10
+static void startRealtime(juce::Thread& thread)
+{
+   #if JUCE_MAJOR_VERSION > 7 || (JUCE_MAJOR_VERSION == 7 && (JUCE_MINOR_VERSION > 0 || JUCE_BUILDNUMBER >= 6))
+    thread.startRealtimeThread(juce::Thread::RealtimeOptions {});
+   #elif JUCE_MAJOR_VERSION == 6 && JUCE_MINOR_VERSION == 0
+    thread.startThread(10);
+   #else
+    thread.startThread(juce::Thread::realtimeAudioPriority);
+   #endif
+}
+
+WorkerPool::WorkerPool()
+    : wake(std::make_unique<Semaphore>())
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    setNumThreads(0);
+}
+
+void WorkerPool::setNumThreads(int numThreads)
+{
+    numThreads = juce::jmax(0, numThreads);
+
+    if (numThreads == getNumThreads())
+        return;
+
+    //One post per worker, each wakes, sees the flag and leaves
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (size_t index = 0; index < workers.size(); index++)
+        wake->post();
+
+    for (auto& worker : workers)
+        worker->stopThread(2000);
+
+    workers.clear();
+
+    for (int index = 0; index < numThreads; index++) {
+
+        workers.push_back(std::make_unique<Worker>(*this, index));
+        startRealtime(*workers.back());
+    }
+}
+
+void WorkerPool::runTasks(int count, TaskFunction function, void* context)
+{
+    //No worker reads these before the tickets below are published
+    taskFunction = function;
+    taskContext = context;
+    pendingTasks.store(count, std::memory_order_relaxed);
+    tickets.store((juce::uint64)(juce::uint32)count << 32, std::memory_order_release);
+
+    //The caller takes one task, every other one may wake a worker
+    const int helpers = juce::jmin(getNumThreads(), count - 1);
+
+    for (int index = 0; index < helpers; index++)
+        wake->post();
+
+    //Every task no worker has claimed yet runs here, so a worker that is slow to wake delays nothing
+    work();
+
+    //Only the tasks a running worker has started are left: spin a little, then give the core away
+    for (int spins = 0; pendingTasks.load(std::memory_order_acquire) > 0; spins++)
+    {
+        if (spins >= maxSpins)
+            std::this_thread::yield();
+    }
+}
+
+void WorkerPool::work()
+{
+    for (;;)
+    {
+        //Count of the run in the high half, next index in the low half: a worker woken after
+        //the run has ended draws an index past the count and claims nothing
+        const auto ticket = tickets.fetch_add(1, std::memory_order_acq_rel);
+        const int count = (int)(ticket >> 32);
+        const int index = (int)(ticket & 0xffffffffu);
+
+        if (index >= count)
+            return;
+
+        taskFunction(taskContext, index);
+        pendingTasks.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    WorkerPool.h
+
+    A few threads that run the channel groups of a block next to the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Small pool of threads for independent tasks of the audio thread.
+
+    The threads are started outside processing, by setNumThreads(). run()
+    publishes the task and its count in one atomic word, posts the semaphore
+    the workers sleep on once per task after the first and takes tasks
+    itself; every thread claims the next index from that word. The calling
+    thread runs every task that no worker has claimed, so a worker that wakes
+    late delays nothing, then waits only for the tasks a worker has already
+    started, spinning a little before it yields. Nothing is allocated and no
+    lock is taken on the calling thread: a post is an atomic increment, with
+    a system call only to wake a sleeping worker.
+*/
+class WorkerPool
+{
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    //Not while run() is in progress: starts numThreads workers, 0 stops them all
+    void setNumThreads(int numThreads);
+    int getNumThreads() const noexcept { return (int)workers.size(); }
+
+    //Calls task(index) for every index below numTasks, on the workers and the calling thread
+    template <typename Task>
+    void run(int numTasks, Task& task)
+    {
+        runTasks(numTasks, [](void* context, int index) { (*static_cast<Task*>(context))(index); }, &task);
+    }
+
+private:
+    using TaskFunction = void (*)(void* context, int index);
+
+    void runTasks(int count, TaskFunction function, void* context);
+
+    //Claims and runs tasks until none is left
+    void work();
+
+    //Checks of the unfinished tasks by the calling thread before it starts yielding
+    static constexpr int maxSpins = 2000;
+
+    class Semaphore;
+    std::unique_ptr<Semaphore> wake;
+
+    class Worker;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    //Task of the current run, written before the tickets are published
+    TaskFunction taskFunction = nullptr;
+    void* taskContext = nullptr;
+
+    //Count of the run << 32 | next index to claim
+    std::atomic<juce::uint64> tickets { 0 };
+
+    //Tasks of the run not finished yet
+    std::atomic<int> pendingTasks { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkerPool)
+};